@@ -20,7 +20,7 @@
 typedef struct
 {
     void (*ymodem_send_data)(uint8_t *buf, uint16_t length);//发送数据函数
-    void (*ymodem_receive_data)(uint8_t *buf, uint16_t length);//接收数据函数
+    uint8_t (*ymodem_receive_data)(uint8_t *buf, uint16_t length);//接收数据函数，成功返回1，失败0
     uint8_t (*ymodem_wait)(uint16_t wait_time);//等待函数
 
     uint8_t (*ymodem_rx_header_callback)(char *file_name, uint16_t file_size);//首包接收成功后对文件名和大小的处理，成功返回1，失败0
@@ -30,6 +30,7 @@ typedef struct
 
 void set_ymodem_rx_enable_flag(void);
 void clear_ymodem_rx_enable_flag(void);
+void ymodem_rx_start(void);
 uint8_t get_ymodem_rx_enable_status(void);
 void set_ymodem_receive_end_flag(void);
 void clear_ymodem_receive_end_flag(void);
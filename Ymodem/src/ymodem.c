@@ -177,7 +177,10 @@ void ymodem_rx_task(void)
     {
         case YM_RX_IDLE:
             if(get_ymodem_rx_enable_status())
+            {
+                ymodem_rx_start();
                 ymodem_rx_sta = YM_RX_HANDLE;
+            }
             break;
 
         case YM_RX_HANDLE:
@@ -9,15 +9,26 @@
  *
  */
 
-#include "ymodem_port.h"
+#include "ymodem.h"
 #include "usart.h"
 
+/*
+ * UART1_RX_FRAME下一帧即一个数据包，传输期间占用usart.c的按帧接收；
+ * 其他接收方式下从terb按首字节确定包长拼出数据包，terb需能容纳两次查询之间收到的数据
+ */
+
 Ymodem_drive_t ymodem_drive;
 
-static uint8_t *ymodem_rx_buff = NULL;
-static uint16_t *ymodem_rx_len = NULL;
 static uint8_t ymodem_rx_enable_flag = 0;
 static uint8_t ymodem_receive_end_flag = 0;
+static uint8_t ymodem_rx_started = 0;   // ymodem_rx_start之后、传输结束之前
+static uint16_t ymodem_frame_len = 0;
+#if UART1_RX_MODE == UART1_RX_FRAME
+static uint8_t *ymodem_frame = NULL;    // 正在处理的帧，下一次查询接收状态时释放
+#else
+static uint8_t ymodem_frame[PACKET_1K_SIZE + PACKET_OVERHEAD_SIZE];
+static uint16_t ymodem_frame_need = 0;  // 当前数据包的长度
+#endif
 
 
 static void _ymodem_send_data(uint8_t *buf, uint16_t length)
@@ -25,9 +36,12 @@ static void _ymodem_send_data(uint8_t *buf, uint16_t length)
 	DMA_UART_Send(buf, length);
 }
 
-static void _ymodem_receive_data(uint8_t *buf, uint16_t length)
+static uint8_t _ymodem_receive_data(uint8_t *buf, uint16_t length)
 {
-	DMA_UART_Receive(buf, length);
+	// 接收DMA由usart.c管理，数据包通过get_ymodem_receive_end_status取得
+	(void)buf;
+	(void)length;
+	return 1;
 }
 
 static uint8_t _ymodem_wait(uint16_t wait_time)
@@ -61,6 +75,34 @@ void set_ymodem_rx_enable_flag(void)
 void clear_ymodem_rx_enable_flag(void)
 {
     ymodem_rx_enable_flag = 0;
+    if (ymodem_rx_started)
+    {
+        // 传输结束或中止，之后收到的数据交还给terb
+        ymodem_rx_started = 0;
+#if UART1_RX_MODE == UART1_RX_FRAME
+        uart1_rx_frame_claim(0);
+        ymodem_frame = NULL;
+#endif
+    }
+}
+
+/**
+ * @brief 开始接收，丢弃此前收到的数据(如启动传输的命令)，避免被当作第一个数据包
+ * @attention 由ymodem_rx_task进入YM_RX_HANDLE时调用
+ *
+ */
+void ymodem_rx_start(void)
+{
+    ymodem_rx_started = 1;
+    ymodem_receive_end_flag = 0;
+    ymodem_frame_len = 0;
+#if UART1_RX_MODE == UART1_RX_FRAME
+    uart1_rx_frame_claim(1);
+    ymodem_frame = NULL;
+#else
+    ymodem_frame_need = 0;
+    uart1_rx_flush();
+#endif
 }
 
 uint8_t get_ymodem_rx_enable_status(void)
@@ -78,25 +120,97 @@ void clear_ymodem_receive_end_flag(void)
     ymodem_receive_end_flag = 0;
 }
 
+#if UART1_RX_MODE == UART1_RX_FRAME
+/**
+ * @brief 查询是否收到新的一帧
+ * @attention 上一帧在清除接收标志后仍可使用，到下一次查询时才释放给DMA，
+ *            处理上一帧的同时下一帧在另一个缓冲区中接收
+ *
+ * @return uint8_t 1:有新的一帧
+ */
+uint8_t get_ymodem_receive_end_status(void)
+{
+    if (!ymodem_receive_end_flag)
+    {
+        if (ymodem_frame)
+        {
+            uart1_rx_frame_release();
+        }
+        ymodem_frame = uart1_rx_frame_get(&ymodem_frame_len);
+        ymodem_receive_end_flag = (ymodem_frame != NULL);
+    }
+    return ymodem_receive_end_flag;
+}
+#else
+/**
+ * @brief 数据包首字节对应的包长
+ *
+ * @param ch: 首字节
+ * @return uint16_t SOH/STX为128/1K数据包的长度，其余为单字节指令
+ */
+static uint16_t ymodem_packet_len(uint8_t ch)
+{
+    if (ch == SOH)
+        return PACKET_SIZE + PACKET_OVERHEAD_SIZE;
+    if (ch == STX)
+        return PACKET_1K_SIZE + PACKET_OVERHEAD_SIZE;
+    return 1;
+}
+
+/**
+ * @brief 查询是否收到新的一个数据包，从terb取出已到达的部分
+ * @attention 上一个数据包在清除接收标志后仍可使用，到下一次查询时才开始接收下一个
+ *
+ * @return uint8_t 1:有新的数据包
+ */
 uint8_t get_ymodem_receive_end_status(void)
 {
+    size_t used, n;
+
+    if (!ymodem_receive_end_flag)
+    {
+        if (ymodem_frame_need && ymodem_frame_len == ymodem_frame_need)
+        {
+            // 上一个数据包已处理完
+            ymodem_frame_len = 0;
+        }
+        used = ringbuf_bytes_used(terb);
+        if (ymodem_frame_len == 0 && used)
+        {
+            ringbuf_read(terb, ymodem_frame, 1);
+            ymodem_frame_len = 1;
+            ymodem_frame_need = ymodem_packet_len(ymodem_frame[0]);
+            used--;
+        }
+        n = ymodem_frame_need - ymodem_frame_len;
+        if (n > used)
+            n = used;
+        if (n)
+        {
+            ringbuf_read(terb, ymodem_frame + ymodem_frame_len, n);
+            ymodem_frame_len += (uint16_t)n;
+        }
+        ymodem_receive_end_flag = (ymodem_frame_len && ymodem_frame_len == ymodem_frame_need);
+    }
     return ymodem_receive_end_flag;
 }
+#endif
 
 uint8_t *get_ymodem_rx_buff(void)
 {
-	return ymodem_rx_buff;
+	return ymodem_frame;
 }
 
 uint16_t get_ymodem_rx_len(void)
 {
-	return (*ymodem_rx_len);
+	return ymodem_frame_len;
 }
 
 uint8_t register_rx_ymodem(uint8_t *rx_buf, uint16_t *rx_len)
 {
-	ymodem_rx_buff = rx_buf;
-	ymodem_rx_len = rx_len;
+	// 帧由usart.c的按帧接收管理，不再使用外部缓冲区
+	(void)rx_buf;
+	(void)rx_len;
 	
 	ymodem_drive.ymodem_send_data = _ymodem_send_data;
     ymodem_drive.ymodem_receive_data = _ymodem_receive_data;
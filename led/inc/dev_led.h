@@ -25,6 +25,15 @@ typedef unsigned           int uint32_t;
 
 #define DEV_NAME_SIZE 16
 
+#define LED_USE_MEM_POOL /* led nodes come from a fixed-size pool instead of malloc */
+
+#ifdef LED_USE_MEM_POOL
+#include "mem_pool.h"
+#ifndef DEV_LED_NODE_NUM
+#define DEV_LED_NODE_NUM 4 /* max led node count */
+#endif
+#endif
+
 typedef struct {
     uint16_t flash_light_time;
     uint16_t recorde_flash_light_time;
@@ -16,6 +16,41 @@
 
 LIST_HEAD(dev_led_head);
 
+#ifdef LED_USE_MEM_POOL
+MEM_POOL_STORAGE(dev_led_node_storage, sizeof(dev_led_node), DEV_LED_NODE_NUM);
+static mem_pool_t *dev_led_node_pool = NULL;
+#endif
+
+/**
+ * @brief alloc a led node
+ *
+ * @return dev_led_node* NULL:faild
+ */
+static dev_led_node *dev_led_node_alloc(void)
+{
+#ifdef LED_USE_MEM_POOL
+    if(dev_led_node_pool == NULL)
+        dev_led_node_pool = mem_pool_create(sizeof(dev_led_node), DEV_LED_NODE_NUM, dev_led_node_storage);
+    return (dev_led_node *)mem_pool_get(dev_led_node_pool);
+#else
+    return (dev_led_node *)malloc(sizeof(dev_led_node));
+#endif
+}
+
+/**
+ * @brief free a led node
+ *
+ * @param node led node
+ */
+static void dev_led_node_free(dev_led_node *node)
+{
+#ifdef LED_USE_MEM_POOL
+    mem_pool_put(dev_led_node_pool, node);
+#else
+    free(node);
+#endif
+}
+
 /**
  * @brief Get the led head object
  *
@@ -78,7 +113,7 @@ int dev_led_close(char *name)
         if(strcmp(name, tmp->dev.name) == 0)
         {
             list_del(pos);
-            free(tmp);
+            dev_led_node_free(tmp);
             return 0;
         }
     }
@@ -104,7 +139,7 @@ int dev_led_add(dev_led *dev)
         }
     }
 
-    node = (dev_led_node *)malloc(sizeof(dev_led_node));
+    node = dev_led_node_alloc();
     if(node == NULL)
         return -1;
     list_add(&(node->list), &dev_led_head);
@@ -0,0 +1,150 @@
+/**
+ * @file mem_arena.c
+ * @author h
+ * @brief 线性(bump)分配器
+ * @version 0.1
+ * @date 2026-10-17
+ * @attention 申请只移动分配位置，没有单独的释放，
+ *            通过arena_mark/arena_release一次性释放检查点之后的所有内存，不会产生碎片。
+ *            典型用法:
+ *              arena_mark_t m = arena_mark(arena);
+ *              hdr = arena_alloc(arena, sizeof(*hdr)); ... // 处理一个数据包
+ *              arena_release(arena, m);
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "mem_arena.h"
+
+#if (MEM_ARENA_ALIGN & (MEM_ARENA_ALIGN - 1)) || MEM_ARENA_ALIGN < 4 \
+    || (UINTPTR_MAX > 0xFFFFFFFFu && MEM_ARENA_ALIGN < 8)
+#error "MEM_ARENA_ALIGN must be a power of 2 and not smaller than sizeof(void*)"
+#endif
+
+/**
+ * @brief 在buf上创建一个线性分配器
+ *
+ * @param buf 内存空间，控制结构占用起始的sizeof(arena_t)字节
+ * @param len 内存空间大小，以Byte为单位
+ * @return arena_t* 分配器句柄，NULL表示参数错误
+ */
+arena_t *arena_init(void *buf, size_t len)
+{
+    arena_t *arena = (arena_t*)ARENA_ALIGN_UP((uintptr_t)buf, sizeof(void*));
+    char *start = (char*)ARENA_ALIGN_UP((uintptr_t)(arena + 1), MEM_ARENA_ALIGN);
+    char *end = (char*)(((uintptr_t)buf + len) & ~((uintptr_t)MEM_ARENA_ALIGN - 1));
+
+    if (!buf || start > end) {
+        return NULL;
+    }
+    arena->start = start;
+    arena->end = end;
+    arena->ptr = start;
+    arena->peak = start;
+    return arena;
+}
+
+/**
+ * @brief 按指定对齐申请内存
+ *
+ * @param arena 分配器句柄
+ * @param size 申请的大小，以Byte为单位
+ * @param align 对齐字节数，必须为2的幂
+ * @return void* 申请到的内存地址，NULL表示空间不足
+ */
+void *arena_alloc_aligned(arena_t *arena, size_t size, size_t align)
+{
+    char *ptr;
+
+    if (align < MEM_ARENA_ALIGN) {
+        align = MEM_ARENA_ALIGN;
+    }
+    ptr = (char*)ARENA_ALIGN_UP((uintptr_t)arena->ptr, align);
+    if (ptr > arena->end || size > (size_t)(arena->end - ptr)) {
+        return NULL;
+    }
+    arena->ptr = ptr + ARENA_ALIGN_UP(size, MEM_ARENA_ALIGN);
+    if (arena->ptr > arena->peak) {
+        arena->peak = arena->ptr;
+    }
+    return ptr;
+}
+
+/**
+ * @brief 申请内存，按MEM_ARENA_ALIGN对齐
+ *
+ * @param arena 分配器句柄
+ * @param size 申请的大小，以Byte为单位
+ * @return void* 申请到的内存地址，NULL表示空间不足
+ */
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    char *ptr = arena->ptr;
+
+    // ptr与end始终按MEM_ARENA_ALIGN对齐，对齐后的size不会越过end
+    if (size > (size_t)(arena->end - ptr)) {
+        return NULL;
+    }
+    arena->ptr = ptr + ARENA_ALIGN_UP(size, MEM_ARENA_ALIGN);
+    if (arena->ptr > arena->peak) {
+        arena->peak = arena->ptr;
+    }
+    return ptr;
+}
+
+/**
+ * @brief 记录当前分配位置
+ *
+ * @param arena 分配器句柄
+ * @return arena_mark_t 检查点
+ */
+arena_mark_t arena_mark(const arena_t *arena)
+{
+    return arena->ptr;
+}
+
+/**
+ * @brief 释放检查点之后申请的所有内存
+ *
+ * @param arena 分配器句柄
+ * @param mark 由arena_mark获取的检查点，检查点之后的mark随之失效
+ */
+void arena_release(arena_t *arena, arena_mark_t mark)
+{
+    if (mark >= arena->start && mark <= arena->ptr) {
+        arena->ptr = mark;
+    }
+}
+
+/**
+ * @brief 释放全部内存
+ *
+ * @param arena 分配器句柄
+ */
+void arena_reset(arena_t *arena)
+{
+    arena->ptr = arena->start;
+}
+
+/**
+ * @brief 查询剩余可申请的空间
+ *
+ * @param arena 分配器句柄
+ * @return size_t 剩余空间，以Byte为单位
+ */
+size_t arena_remaining(const arena_t *arena)
+{
+    return (size_t)(arena->end - arena->ptr);
+}
+
+/**
+ * @brief 查询使用量的峰值，用于确定buf的大小
+ *
+ * @param arena 分配器句柄
+ * @return size_t 峰值使用量，以Byte为单位
+ */
+size_t arena_peak(const arena_t *arena)
+{
+    return (size_t)(arena->peak - arena->start);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file mem_arena.h
+ * @author h
+ * @brief 线性(bump)分配器，用于生命周期为一次处理过程的临时内存
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __MEM_ARENA_H__
+#define __MEM_ARENA_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MEM_ARENA_ALIGN
+#define MEM_ARENA_ALIGN 8 // 返回地址的对齐粒度，必须为2的幂且不小于指针大小
+#endif
+
+// 线性分配器控制结构，存放在buf的起始处
+typedef struct arena {
+    char *start; // 分配区起始地址
+    char *end; // 分配区结束地址
+    char *ptr; // 当前分配位置
+    char *peak; // 分配位置的最高值
+} arena_t;
+
+// 检查点，arena_release回退到该位置
+typedef char *arena_mark_t;
+
+#define ARENA_ALIGN_UP(x, align) (((x) + (align) - 1) & ~((uintptr_t)(align) - 1))
+
+arena_t *arena_init(void *buf, size_t len);
+void *arena_alloc(arena_t *arena, size_t size);
+void *arena_alloc_aligned(arena_t *arena, size_t size, size_t align);
+arena_mark_t arena_mark(const arena_t *arena);
+void arena_release(arena_t *arena, arena_mark_t mark);
+void arena_reset(arena_t *arena);
+size_t arena_remaining(const arena_t *arena);
+size_t arena_peak(const arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_ARENA_H__ */
@@ -0,0 +1,323 @@
+/**
+ * @file mem_handle.c
+ * @author h
+ * @brief 句柄方式访问的可整理堆
+ * @version 0.1
+ * @date 2026-10-17
+ * @attention 使用者只持有句柄，访问数据前用mem_lock获取当前地址，访问结束后mem_unlock。
+ *            未锁定的内存块可被mem_handle_compact移动到低地址，使空闲空间重新连续，
+ *            因此mem_unlock之后不能再使用之前得到的地址。
+ *            锁定的内存块原地不动，整理会跳过它。
+ *            内存池按地址顺序由内存块依次排列，最后一块之后(top之后)为连续空闲区。
+ *            接口不可重入，不可在中断中使用。
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <string.h>
+#include "mem_handle.h"
+
+#define MEM_HANDLE_ALIGN 8
+#define MEM_HANDLE_ALIGN_UP(x) (((x) + MEM_HANDLE_ALIGN - 1) & ~(size_t)(MEM_HANDLE_ALIGN - 1))
+
+// 内存块头部
+typedef struct mem_handle_block {
+    uint32_t size; // 内存块大小(含头部)
+    uint16_t handle; // 所属句柄，0表示空闲块
+    uint16_t reserved;
+} MemHandleBlock;
+
+// 句柄表项
+typedef struct mem_handle_entry {
+    uint32_t offset; // 内存块相对内存池起始的偏移
+    uint32_t size; // 申请大小
+    uint16_t lock; // 锁定计数
+    uint16_t used; // 1:已分配
+} MemHandleEntry;
+
+#define MEM_HANDLE_HEAD_SIZE MEM_HANDLE_ALIGN_UP(sizeof(MemHandleBlock))
+#define MEM_HANDLE_POOL_SIZE (MEM_HANDLE_SIZE & ~(MEM_HANDLE_ALIGN - 1))
+
+static uint64_t handle_pool[MEM_HANDLE_POOL_SIZE / sizeof(uint64_t)];
+static MemHandleEntry handle_table[MEM_HANDLE_NUM + 1]; // 0号不使用
+static uint32_t handle_top = 0; // 最后一个内存块的结束偏移
+static uint32_t handle_free_size = 0; // top之前的空闲块大小之和
+// 分步整理的进度：[compact_dst, compact_src)为一个空闲块，compact_src之前已整理
+static uint32_t compact_src = 0;
+static uint32_t compact_dst = 0;
+
+static inline MemHandleBlock *handle_block(uint32_t offset)
+{
+    return (MemHandleBlock*)((char*)handle_pool + offset);
+}
+
+static inline void compact_cancel(void)
+{
+    compact_src = 0;
+    compact_dst = 0;
+}
+
+/**
+ * @brief 初始化可整理堆
+ *
+ */
+void mem_handle_init(void)
+{
+    memset(handle_table, 0, sizeof(handle_table));
+    handle_top = 0;
+    handle_free_size = 0;
+    compact_cancel();
+}
+
+/**
+ * @brief 在[offset, offset + size)写入一个空闲块
+ *
+ */
+static void handle_set_free(uint32_t offset, uint32_t size)
+{
+    MemHandleBlock *block = handle_block(offset);
+    block->size = size;
+    block->handle = 0;
+}
+
+/**
+ * @brief 从top之前的空闲块中首次适配，途中合并相邻的空闲块
+ *
+ * @param size 内存块大小(含头部)
+ * @return uint32_t 内存块偏移，handle_top表示没有合适的空闲块
+ */
+static uint32_t handle_find_free(uint32_t size)
+{
+    uint32_t offset = 0, next;
+    MemHandleBlock *block;
+
+    if (handle_free_size < size) {
+        return handle_top;
+    }
+    while (offset < handle_top) {
+        block = handle_block(offset);
+        if (!block->handle) {
+            next = offset + block->size;
+            while (next < handle_top && !handle_block(next)->handle) {
+                block->size += handle_block(next)->size;
+                next = offset + block->size;
+            }
+            if (next == handle_top) {
+                // 最后一块空闲，并入top之后的空闲区
+                handle_free_size -= block->size;
+                handle_top = offset;
+                break;
+            }
+            if (block->size >= size) {
+                if (block->size - size >= MEM_HANDLE_HEAD_SIZE) {
+                    handle_set_free(offset + size, block->size - size);
+                    block->size = size;
+                }
+                handle_free_size -= block->size;
+                return offset;
+            }
+        }
+        offset += block->size;
+    }
+    return handle_top;
+}
+
+/**
+ * @brief 申请内存
+ *
+ * @param size 申请的大小，以Byte为单位
+ * @return mem_handle_t 句柄，MEM_HANDLE_INVALID表示申请失败
+ */
+mem_handle_t mem_handle_alloc(size_t size)
+{
+    mem_handle_t handle;
+    uint32_t block_size, offset;
+    MemHandleBlock *block;
+
+    if (!size || size > MEM_HANDLE_POOL_SIZE) {
+        return MEM_HANDLE_INVALID;
+    }
+    for (handle = 1; handle <= MEM_HANDLE_NUM && handle_table[handle].used; handle++) {
+    }
+    if (handle > MEM_HANDLE_NUM) {
+        return MEM_HANDLE_INVALID;
+    }
+
+    compact_cancel();
+    block_size = MEM_HANDLE_HEAD_SIZE + MEM_HANDLE_ALIGN_UP(size);
+    offset = handle_find_free(block_size);
+    if (offset == handle_top && MEM_HANDLE_POOL_SIZE - handle_top < block_size) {
+        // 空闲空间足够但不连续时整理后重试
+        if (mem_handle_free_size() < block_size) {
+            return MEM_HANDLE_INVALID;
+        }
+        mem_handle_compact(0);
+        offset = handle_find_free(block_size);
+        if (offset == handle_top && MEM_HANDLE_POOL_SIZE - handle_top < block_size) {
+            return MEM_HANDLE_INVALID; // 被锁定的内存块分隔
+        }
+    }
+
+    block = handle_block(offset);
+    if (offset == handle_top) {
+        block->size = block_size;
+        handle_top += block_size;
+    }
+    block->handle = handle;
+    handle_table[handle].offset = offset;
+    handle_table[handle].size = size;
+    handle_table[handle].lock = 0;
+    handle_table[handle].used = 1;
+    return handle;
+}
+
+static inline MemHandleEntry *handle_entry(mem_handle_t handle)
+{
+    if (handle == MEM_HANDLE_INVALID || handle > MEM_HANDLE_NUM || !handle_table[handle].used) {
+        return NULL;
+    }
+    return &handle_table[handle];
+}
+
+/**
+ * @brief 释放内存
+ *
+ * @param handle 句柄，锁定状态下也可释放
+ */
+void mem_handle_free(mem_handle_t handle)
+{
+    MemHandleEntry *entry = handle_entry(handle);
+    MemHandleBlock *block;
+
+    if (!entry) {
+        return;
+    }
+    compact_cancel();
+    block = handle_block(entry->offset);
+    block->handle = 0;
+    if (entry->offset + block->size == handle_top) {
+        handle_top = entry->offset;
+    } else {
+        handle_free_size += block->size;
+    }
+    entry->used = 0;
+}
+
+/**
+ * @brief 查询句柄对应内存的大小
+ *
+ * @param handle 句柄
+ * @return size_t 申请时的大小，句柄无效时为0
+ */
+size_t mem_handle_size(mem_handle_t handle)
+{
+    MemHandleEntry *entry = handle_entry(handle);
+    return entry ? entry->size : 0;
+}
+
+/**
+ * @brief 锁定内存块并获取其地址，锁定期间内存块不会被移动
+ *
+ * @param handle 句柄
+ * @return void* 内存地址，NULL表示句柄无效
+ */
+void *mem_lock(mem_handle_t handle)
+{
+    MemHandleEntry *entry = handle_entry(handle);
+
+    if (!entry) {
+        return NULL;
+    }
+    entry->lock++;
+    return (char*)handle_block(entry->offset) + MEM_HANDLE_HEAD_SIZE;
+}
+
+/**
+ * @brief 解除锁定，之后内存块可能被移动，mem_lock得到的地址失效
+ *
+ * @param handle 句柄
+ */
+void mem_unlock(mem_handle_t handle)
+{
+    MemHandleEntry *entry = handle_entry(handle);
+
+    if (entry && entry->lock) {
+        entry->lock--;
+    }
+}
+
+/**
+ * @brief 整理内存：把未锁定的内存块依次移动到低地址，空闲空间合并到top之后
+ * @attention 可在空闲任务中以较小的budget反复调用，分步完成整理；
+ *            中途的申请/释放会使整理从头开始
+ *
+ * @param budget 本次最多移动的字节数，0表示一次整理完成
+ * @return int 1:整理已完成 0:尚未完成
+ */
+int mem_handle_compact(size_t budget)
+{
+    MemHandleBlock *block;
+    uint32_t size;
+    size_t moved = 0;
+
+    while (compact_src < handle_top) {
+        block = handle_block(compact_src);
+        size = block->size;
+        if (!block->handle) {
+            handle_free_size -= size;
+        } else if (handle_table[block->handle].lock) {
+            // 锁定的块原地保留，前面的空隙成为一个空闲块
+            if (compact_dst != compact_src) {
+                handle_set_free(compact_dst, compact_src - compact_dst);
+                handle_free_size += compact_src - compact_dst;
+            }
+            compact_dst = compact_src + size;
+        } else {
+            if (budget && moved && moved + size > budget) {
+                break;
+            }
+            if (compact_dst != compact_src) {
+                memmove(handle_block(compact_dst), block, size);
+                handle_table[handle_block(compact_dst)->handle].offset = compact_dst;
+                moved += size;
+            }
+            compact_dst += size;
+        }
+        compact_src += size;
+    }
+
+    if (compact_src < handle_top) {
+        // 未完成，[compact_dst, compact_src)保持为一个合法的空闲块
+        if (compact_dst != compact_src) {
+            handle_set_free(compact_dst, compact_src - compact_dst);
+            handle_free_size += compact_src - compact_dst;
+        }
+        compact_src = compact_dst;
+        return 0;
+    }
+    handle_top = compact_dst;
+    compact_cancel();
+    return 1;
+}
+
+/**
+ * @brief 查询空闲空间总量
+ *
+ * @return size_t 空闲空间，以Byte为单位(含头部)
+ */
+size_t mem_handle_free_size(void)
+{
+    return handle_free_size + MEM_HANDLE_POOL_SIZE - handle_top;
+}
+
+/**
+ * @brief 查询最大的连续空闲空间(top之后的空闲区)，整理完成后等于mem_handle_free_size
+ *
+ * @return size_t 可申请的最大大小，以Byte为单位
+ */
+size_t mem_handle_largest_free(void)
+{
+    size_t size = MEM_HANDLE_POOL_SIZE - handle_top;
+    return size > MEM_HANDLE_HEAD_SIZE ? size - MEM_HANDLE_HEAD_SIZE : 0;
+}
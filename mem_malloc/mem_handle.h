@@ -0,0 +1,51 @@
+/**
+ * @file mem_handle.h
+ * @author h
+ * @brief 句柄方式访问的可整理堆，空闲时移动内存块消除碎片
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __MEM_HANDLE_H__
+#define __MEM_HANDLE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ config ---------------------------------//
+#ifndef MEM_HANDLE_SIZE
+#define MEM_HANDLE_SIZE 1024 // 可整理堆的内存池大小
+#endif
+
+#ifndef MEM_HANDLE_NUM
+#define MEM_HANDLE_NUM 32 // 句柄数量，即同时存在的内存块数量上限
+#endif
+
+//------------------------------ typedef --------------------------------//
+typedef uint16_t mem_handle_t; // 句柄，0表示无效
+
+#define MEM_HANDLE_INVALID 0
+
+void mem_handle_init(void);
+mem_handle_t mem_handle_alloc(size_t size);
+void mem_handle_free(mem_handle_t handle);
+size_t mem_handle_size(mem_handle_t handle);
+void *mem_lock(mem_handle_t handle);
+void mem_unlock(mem_handle_t handle);
+int mem_handle_compact(size_t budget);
+size_t mem_handle_free_size(void);
+size_t mem_handle_largest_free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_HANDLE_H__ */
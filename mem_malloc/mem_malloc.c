@@ -2,148 +2,1961 @@
  * @file mem_malloc.c
  * @author h
  * @brief 静态内存池方式实现的内存malloc free memory
- * @version 0.1
+ * @version 0.2
  * @date 2023-03-22
  * @attention 申请到的内存不一定为0，使用前需要清零
+ *            分配算法为TLSF(两级分离适配)：
+ *            一级索引按2的幂划分区间，二级索引将每个区间线性细分，
+ *            通过位图+前导零计数查找空闲链表，mem_alloc/mem_free均为O(1)
+ *            内存块采用边界标记：已使用块只有一个size字(低位存放标志)，
+ *            空闲块在负载区中存放空闲链表指针，并在末尾存放size(footer)，
+ *            释放时通过footer直接定位物理上的前一个空闲块
  *
  * @copyright Copyright (c) 2023
  *
  */
 
 #include <string.h>
+#include <stdint.h>
 #include "mem_malloc.h"
 
 //------------------------------ private ---------------------------------//
-#define MEM_SIZE 1024 // 内存池大小
-static char memory_pool[MEM_SIZE] = {0}; // 静态内存池
+#define MEM_SMALL_BLOCK_SIZE (1 << MEM_FL_INDEX_SHIFT) // 小于此大小的块全部落在一级索引0中
+
+#define MEM_ALIGN_UP(x) (((x) + (MEM_ALIGN_SIZE - 1)) & ~(size_t)(MEM_ALIGN_SIZE - 1))
+#define MEM_ALIGN_DOWN(x) ((x) & ~(size_t)(MEM_ALIGN_SIZE - 1))
+
+#if MEM_BUDDY && (defined(__GNUC__) || defined(__CC_ARM) || defined(__clang__))
+// 伙伴模式下内存池按自身大小对齐，块地址即按块大小自然对齐
+static size_t memory_pool[MEM_SIZE / sizeof(size_t)] __attribute__((aligned(MEM_SIZE))) = {0};
+#else
+static size_t memory_pool[MEM_SIZE / sizeof(size_t)] = {0}; // 默认堆的静态内存池，按size_t对齐
+#endif
+#if !MEM_BUDDY
+static mem_heap_t mem_default_heap; // 默认堆
+#endif
 
 //------------------------------ typedef --------------------------------//
-// 内存块结构体
+// 内存块头，紧挨负载区之前
 typedef struct mem_block {
-    size_t size; // 内存块大小
-    int used; // 是否被使用
-    struct mem_block *next; // 下一个内存块
-    struct mem_block *prev; // 前一个内存块
+    size_t size; // 内存块大小，低两位为标志位，见MEM_BLOCK_xxx_BIT
 } MemBlock;
 
+// 空闲链表节点，仅空闲块有效，存放在负载区起始处
+typedef struct mem_free_link {
+    MemBlock *next; // 空闲链表中的下一个内存块
+    MemBlock *prev; // 空闲链表中的前一个内存块
+} MemFreeLink;
+
+#define MEM_BLOCK_USED_BIT ((size_t)1 << 0) // 本块已使用
+#define MEM_BLOCK_PREV_FREE_BIT ((size_t)1 << 1) // 物理上前一块为空闲块，其footer有效
+#define MEM_BLOCK_FLAG_MASK (MEM_BLOCK_USED_BIT | MEM_BLOCK_PREV_FREE_BIT)
+
+#define MEM_BLOCK_HEADER_SIZE MEM_ALIGN_UP(sizeof(MemBlock))
+// 空闲块需容纳链表节点和footer
+#define MEM_BLOCK_SIZE_MIN MEM_ALIGN_UP(sizeof(MemFreeLink) + sizeof(size_t))
+#define MEM_BLOCK_SIZE_MAX ((size_t)1 << MEM_FL_INDEX_MAX)
+
+#if MEM_SIZE >= (1 << MEM_FL_INDEX_MAX)
+#error "MEM_SIZE too large, increase MEM_FL_INDEX_MAX"
+#endif
+
+#if MEM_STATS
+#ifndef MEM_STATS_CYCLES
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+// DWT->CYCCNT，需要在启动时使能(CoreDebug->DEMCR |= TRCENA, DWT->CTRL |= CYCCNTENA)
+#define MEM_STATS_CYCLES() (*(volatile uint32_t *)0xE0001004u)
+#else
+#define MEM_STATS_CYCLES() 0u
+#endif
+#endif
+#endif
+
+//------------------------------ bit ops --------------------------------//
+#if defined(__GNUC__) || defined(__clang__)
+#define mem_clz(x) __builtin_clz(x)
+#elif defined(__CC_ARM)
+#define mem_clz(x) __clz(x)
+#else
+static int mem_clz(uint32_t x)
+{
+    int n = 0;
+    while (!(x & 0x80000000u)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+#endif
 
 /**
- * @brief 初始化内存申请内存池
+ * @brief 查找最高置位bit(find last set)
  *
+ * @param word 非0的值
+ * @return int 最高置位bit的序号
  */
-void mem_init(void)
+static inline int mem_fls(uint32_t word)
 {
-    MemBlock *block = (MemBlock*)memory_pool;
-    block->size = MEM_SIZE - sizeof(MemBlock);
-    block->next = block->prev = NULL;
-    block->used = 0;
+    return 31 - mem_clz(word);
 }
 
 /**
- * @brief 内存申请
+ * @brief 查找最低置位bit(find first set)
  *
- * @param size 要申请的内存大小，以Byte为单位
- * @return void* 申请到的内存的地址，NULL表示申请失败
+ * @param word 非0的值
+ * @return int 最低置位bit的序号
  */
-void *mem_alloc(size_t size)
+static inline int mem_ffs(uint32_t word)
+{
+    return mem_fls(word & (~word + 1));
+}
+
+//------------------------------ block ops --------------------------------//
+static inline void *block_to_ptr(const MemBlock *block)
+{
+    return (void*)((char*)block + MEM_BLOCK_HEADER_SIZE);
+}
+
+static inline MemBlock *block_from_ptr(const void *ptr)
+{
+    return (MemBlock*)((char*)ptr - MEM_BLOCK_HEADER_SIZE);
+}
+
+static inline size_t block_size(const MemBlock *block)
+{
+    return block->size & ~MEM_BLOCK_FLAG_MASK;
+}
+
+static inline void block_set_size(MemBlock *block, size_t size)
+{
+    block->size = size | (block->size & MEM_BLOCK_FLAG_MASK);
+}
+
+static inline int block_is_free(const MemBlock *block)
+{
+    return !(block->size & MEM_BLOCK_USED_BIT);
+}
+
+static inline int block_is_prev_free(const MemBlock *block)
+{
+    return (block->size & MEM_BLOCK_PREV_FREE_BIT) != 0;
+}
+
+static inline MemFreeLink *block_link(const MemBlock *block)
+{
+    return (MemFreeLink*)block_to_ptr(block);
+}
+
+static inline MemBlock *block_next_phys(const MemBlock *block)
+{
+    return (MemBlock*)((char*)block_to_ptr(block) + block_size(block));
+}
+
+/**
+ * @brief 通过footer获取物理上的前一个内存块，仅在前一块空闲时有效
+ *
+ * @param block 内存块
+ * @return MemBlock* 前一个内存块
+ */
+static inline MemBlock *block_prev_phys(const MemBlock *block)
+{
+    size_t prev_size = *((size_t*)block - 1);
+    return (MemBlock*)((char*)block - prev_size - MEM_BLOCK_HEADER_SIZE);
+}
+
+/**
+ * @brief 标记为空闲：写footer，并通知物理上的后一块
+ *
+ * @param block 内存块
+ */
+static void block_mark_as_free(MemBlock *block)
+{
+    MemBlock *next = block_next_phys(block);
+    block->size &= ~MEM_BLOCK_USED_BIT;
+    *((size_t*)next - 1) = block_size(block);
+    next->size |= MEM_BLOCK_PREV_FREE_BIT;
+}
+
+/**
+ * @brief 标记为已使用，并通知物理上的后一块
+ *
+ * @param block 内存块
+ */
+static void block_mark_as_used(MemBlock *block)
+{
+    block->size |= MEM_BLOCK_USED_BIT;
+    block_next_phys(block)->size &= ~MEM_BLOCK_PREV_FREE_BIT;
+}
+
+/**
+ * @brief 计算size对应的一级、二级索引
+ *
+ * @param size 内存块大小
+ * @param fli 一级索引
+ * @param sli 二级索引
+ */
+static void mapping_insert(size_t size, int *fli, int *sli)
 {
-    MemBlock *curr_block = (MemBlock*)memory_pool;
-
-    // 遍历内存池查找合适的内存块
-    while (curr_block)
-    {
-        if ((!curr_block->used) && (curr_block->size >= size))
-        {
-            // 找到合适的空闲内存块
-            if (curr_block->size - size >= sizeof(MemBlock))
-            {
-                // 内存块大小大于size，需要拆分出一块空闲内存
-                MemBlock *new_block = (MemBlock*)((char*)curr_block + sizeof(MemBlock) + size);
-                new_block->size = curr_block->size - sizeof(MemBlock) - size;
-                new_block->next = curr_block->next;
-                new_block->prev = curr_block;
-                new_block->used = 0;
-                curr_block->size = size;
-                curr_block->next = new_block;
+    int fl, sl;
+    if (size < MEM_SMALL_BLOCK_SIZE) {
+        // 小块线性划分
+        fl = 0;
+        sl = (int)size / (MEM_SMALL_BLOCK_SIZE / MEM_SL_INDEX_COUNT);
+    } else {
+        fl = mem_fls((uint32_t)size);
+        sl = (int)(size >> (fl - MEM_SL_INDEX_COUNT_LOG2)) ^ (1 << MEM_SL_INDEX_COUNT_LOG2);
+        fl -= (MEM_FL_INDEX_SHIFT - 1);
+    }
+    *fli = fl;
+    *sli = sl;
+}
+
+/**
+ * @brief 申请时的索引计算，向上取整到下一个二级区间，
+ *        保证该链表中任意一块都能满足size，无需遍历链表
+ *
+ * @param size 申请大小
+ * @param fli 一级索引
+ * @param sli 二级索引
+ */
+static void mapping_search(size_t size, int *fli, int *sli)
+{
+    if (size >= MEM_SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (mem_fls((uint32_t)size) - MEM_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, fli, sli);
+}
+
+/**
+ * @brief 通过位图查找满足索引的最小非空空闲链表
+ *
+ * @param heap 堆句柄
+ * @param fli 一级索引，返回实际找到的一级索引
+ * @param sli 二级索引，返回实际找到的二级索引
+ * @return MemBlock* 空闲块，NULL表示没有满足条件的空闲块
+ */
+static MemBlock *search_suitable_block(mem_heap_t *heap, int *fli, int *sli)
+{
+    int fl = *fli;
+    int sl = *sli;
+    uint32_t sl_map, fl_map;
+
+    if (fl >= MEM_FL_INDEX_COUNT) {
+        return NULL;
+    }
+    sl_map = heap->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        // 当前一级区间没有，查找更大的一级区间
+        fl_map = (fl + 1 < 32) ? (heap->fl_bitmap & (~0u << (fl + 1))) : 0;
+        if (!fl_map) {
+            return NULL;
+        }
+        fl = mem_ffs(fl_map);
+        sl_map = heap->sl_bitmap[fl];
+    }
+    sl = mem_ffs(sl_map);
+    *fli = fl;
+    *sli = sl;
+    return heap->blocks[fl][sl];
+}
+
+static void remove_free_block(mem_heap_t *heap, MemBlock *block, int fl, int sl)
+{
+    MemBlock *prev = block_link(block)->prev;
+    MemBlock *next = block_link(block)->next;
+    if (next) {
+        block_link(next)->prev = prev;
+    }
+    if (prev) {
+        block_link(prev)->next = next;
+    }
+#if MEM_STATS
+    heap->stats.free_size -= block_size(block);
+    heap->stats.free_blocks--;
+#endif
+    if (heap->blocks[fl][sl] == block) {
+        heap->blocks[fl][sl] = next;
+        if (!next) {
+            // 链表为空，清除位图
+            heap->sl_bitmap[fl] &= ~(1u << sl);
+            if (!heap->sl_bitmap[fl]) {
+                heap->fl_bitmap &= ~(1u << fl);
             }
-            // 标记内存块为已使用
-            curr_block->used = 1;
-            // 返回内存块指针
-            return (void*)((char*)curr_block + sizeof(MemBlock));
         }
-        curr_block = curr_block->next;
     }
-    // 没有找到合适的内存块，返回NULL
-    return NULL;
+}
+
+static void insert_free_block(mem_heap_t *heap, MemBlock *block, int fl, int sl)
+{
+    MemBlock *curr = heap->blocks[fl][sl];
+    block_link(block)->next = curr;
+    block_link(block)->prev = NULL;
+    if (curr) {
+        block_link(curr)->prev = block;
+    }
+    heap->blocks[fl][sl] = block;
+#if MEM_STATS
+    heap->stats.free_size += block_size(block);
+    heap->stats.free_blocks++;
+#endif
+    heap->fl_bitmap |= (1u << fl);
+    heap->sl_bitmap[fl] |= (1u << sl);
+}
+
+static void block_remove(mem_heap_t *heap, MemBlock *block)
+{
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    remove_free_block(heap, block, fl, sl);
+}
+
+static void block_insert(mem_heap_t *heap, MemBlock *block)
+{
+    int fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    insert_free_block(heap, block, fl, sl);
+}
+
+/**
+ * @brief 内存块拆分，剩余部分足够大时拆出一个新的空闲块
+ *
+ * @param heap 堆句柄
+ * @param block 被拆分的内存块(不在空闲链表中，拆分后标记为已使用)
+ * @param size 保留的大小
+ */
+static void block_split(mem_heap_t *heap, MemBlock *block, size_t size)
+{
+    if (block_size(block) >= size + MEM_BLOCK_HEADER_SIZE + MEM_BLOCK_SIZE_MIN) {
+        MemBlock *remaining = (MemBlock*)((char*)block_to_ptr(block) + size);
+        remaining->size = block_size(block) - size - MEM_BLOCK_HEADER_SIZE;
+        block_set_size(block, size);
+        block_mark_as_free(remaining);
+        block_insert(heap, remaining);
+    }
+    block_mark_as_used(block);
 }
 
 /**
- * @brief 内存释放
+ * @brief 与物理相邻的前一个空闲块合并
  *
- * @param ptr 要释放内存的指针
+ * @param heap 堆句柄
+ * @param block 内存块(不在空闲链表中)
+ * @return MemBlock* 合并后的内存块
  */
-void mem_free(void *ptr) {
-    if (!ptr) {
+static MemBlock *block_merge_prev(mem_heap_t *heap, MemBlock *block)
+{
+    if (block_is_prev_free(block)) {
+        MemBlock *prev = block_prev_phys(block);
+        block_remove(heap, prev);
+        block_set_size(prev, block_size(prev) + MEM_BLOCK_HEADER_SIZE + block_size(block));
+        block = prev;
+    }
+    return block;
+}
+
+/**
+ * @brief 与物理相邻的后一个空闲块合并
+ *
+ * @param heap 堆句柄
+ * @param block 内存块(不在空闲链表中)
+ * @return MemBlock* 合并后的内存块
+ */
+static MemBlock *block_merge_next(mem_heap_t *heap, MemBlock *block)
+{
+    MemBlock *next = block_next_phys(block);
+    if (block_is_free(next)) {
+        block_remove(heap, next);
+        block_set_size(block, block_size(block) + MEM_BLOCK_HEADER_SIZE + block_size(next));
+    }
+    return block;
+}
+
+/**
+ * @brief 已使用内存块尾部裁剪，剩余部分足够大时拆出并与后一块空闲块合并后归还
+ *
+ * @param heap 堆句柄
+ * @param block 已使用的内存块
+ * @param size 保留的大小
+ */
+static void block_trim_used(mem_heap_t *heap, MemBlock *block, size_t size)
+{
+    if (block_size(block) >= size + MEM_BLOCK_HEADER_SIZE + MEM_BLOCK_SIZE_MIN) {
+        MemBlock *remaining = (MemBlock*)((char*)block_to_ptr(block) + size);
+        remaining->size = block_size(block) - size - MEM_BLOCK_HEADER_SIZE;
+        block_set_size(block, size);
+        remaining = block_merge_next(heap, remaining);
+        block_mark_as_free(remaining);
+        block_insert(heap, remaining);
+    }
+}
+
+/**
+ * @brief 申请大小对齐并限制最小值
+ *
+ * @param size 申请的大小
+ * @return size_t 调整后的大小，0表示超出范围
+ */
+static size_t adjust_request_size(size_t size)
+{
+    size_t adjust;
+    if (size >= MEM_BLOCK_SIZE_MAX) {
+        return 0;
+    }
+    adjust = MEM_ALIGN_UP(size);
+    return adjust < MEM_BLOCK_SIZE_MIN ? MEM_BLOCK_SIZE_MIN : adjust;
+}
+
+#if MEM_STATS
+/**
+ * @brief 统计一次申请的结果
+ *
+ * @param heap 堆句柄
+ * @param block 申请到的内存块，NULL表示申请失败
+ * @param start 申请开始时的周期计数
+ */
+static void mem_stats_alloc(mem_heap_t *heap, const MemBlock *block, uint32_t start)
+{
+    uint32_t cycles = MEM_STATS_CYCLES() - start;
+    int bin = cycles ? mem_fls(cycles) : 0;
+
+    if (!block) {
+        heap->stats.fail_count++;
         return;
     }
-    MemBlock *curr_block = (MemBlock*)((char*)ptr - sizeof(MemBlock));
-    // 标记内存块为未使用
-    curr_block->used = 0;
-    MemBlock *prev_block = curr_block->prev;
-    MemBlock *next_block = curr_block->next;
-    // 合并相邻的空闲内存块
-    while (next_block) {
-        if (!next_block->used && (char*)curr_block + sizeof(MemBlock) + curr_block->size == (char*)next_block) {
-            curr_block->size += sizeof(MemBlock) + next_block->size;
-            curr_block->next = next_block->next;
-            // memset(next_block, 0, sizeof(MemBlock));
-            next_block = curr_block->next;
-        } else {
-            break;
+    heap->stats.alloc_count++;
+    heap->stats.used_size += block_size(block);
+    if (heap->stats.used_size > heap->stats.peak_used_size) {
+        heap->stats.peak_used_size = heap->stats.used_size;
+    }
+    heap->stats.alloc_hist[bin < MEM_STATS_HIST_BINS ? bin : MEM_STATS_HIST_BINS - 1]++;
+}
+#endif
+
+/**
+ * @brief 释放内存块：通过边界标记合并物理相邻的空闲内存块后放回空闲链表
+ *
+ * @param heap 堆句柄
+ * @param block 已使用的内存块
+ */
+static void block_release(mem_heap_t *heap, MemBlock *block)
+{
+    block = block_merge_prev(heap, block);
+    block = block_merge_next(heap, block);
+    block_mark_as_free(block);
+    block_insert(heap, block);
+}
+
+#if MEM_QUICK_LIST
+/*
+ * 快速链表：释放的热点大小内存块保持已使用状态暂存在对应链表中，不合并，
+ * 下一次同尺寸申请直接取出，省去拆分/合并；申请失败时才全部合并回堆后重试
+ */
+static const size_t mem_quick_sizes[] = {MEM_QUICK_SIZES};
+
+typedef char mem_quick_num_check[sizeof(mem_quick_sizes) / sizeof(mem_quick_sizes[0]) == MEM_QUICK_NUM ? 1 : -1];
+
+// 超过默认堆大小的热点大小永远申请不到，预处理阶段取MEM_QUICK_SIZES的最大值检查，最多8个
+#define MEM_QUICK_MAX2(a, b) ((a) > (b) ? (a) : (b))
+#define MEM_QUICK_MAX8(a, b, c, d, e, f, g, h, ...) \
+    MEM_QUICK_MAX2(MEM_QUICK_MAX2(MEM_QUICK_MAX2(a, b), MEM_QUICK_MAX2(c, d)), \
+                   MEM_QUICK_MAX2(MEM_QUICK_MAX2(e, f), MEM_QUICK_MAX2(g, h)))
+#define MEM_QUICK_MAX(...) MEM_QUICK_MAX8(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0)
+
+#if MEM_QUICK_NUM > 8
+#error "MEM_QUICK_NUM must not exceed 8"
+#endif
+#if MEM_QUICK_MAX(MEM_QUICK_SIZES) > MEM_SIZE
+#error "MEM_QUICK_SIZES must not exceed MEM_SIZE"
+#endif
+
+/**
+ * @brief 查找内存块大小对应的快速链表
+ *
+ * @param size 内存块大小(已对齐)
+ * @return int 快速链表序号，-1表示不是热点大小
+ */
+static int mem_quick_index(size_t size)
+{
+    int i, index = -1;
+    size_t quick_size, best = 0;
+
+    for (i = 0; i < MEM_QUICK_NUM; i++) {
+        quick_size = adjust_request_size(mem_quick_sizes[i]);
+        // 拆分剩余不足一个最小块时内存块会略大于申请大小，取不大于size的最接近的热点大小
+        if (size >= quick_size && size < quick_size + MEM_BLOCK_HEADER_SIZE + MEM_BLOCK_SIZE_MIN
+            && quick_size > best) {
+            best = quick_size;
+            index = i;
         }
     }
-    while (prev_block) {
-        if (!prev_block->used && (char*)prev_block + sizeof(MemBlock) + prev_block->size == (char*)curr_block) {
-            prev_block->size += sizeof(MemBlock) + curr_block->size;
-            prev_block->next = curr_block->next;
-            // memset(curr_block, 0, sizeof(MemBlock));
-            prev_block = prev_block->prev;
-        } else {
+    return index;
+}
+
+/**
+ * @brief 从快速链表中取出一个内存块
+ *
+ * @param heap 堆句柄
+ * @param size 已对齐的申请大小
+ * @return MemBlock* 已使用状态的内存块，NULL表示链表为空或不是热点大小
+ */
+static MemBlock *mem_quick_pop(mem_heap_t *heap, size_t size)
+{
+    int i;
+    MemBlock *block;
+
+    for (i = 0; i < MEM_QUICK_NUM; i++) {
+        if (adjust_request_size(mem_quick_sizes[i]) == size) {
             break;
         }
     }
+    if (i == MEM_QUICK_NUM || !heap->quick[i]) {
+        return NULL;
+    }
+    block = heap->quick[i];
+    heap->quick[i] = block_link(block)->next;
+    heap->quick_count[i]--;
+#if MEM_STATS
+    heap->stats.free_size -= block_size(block);
+    heap->stats.free_blocks--;
+#endif
+    return block;
 }
-// 内存重新分配函数
+
 /**
- * @brief 重新分配内存，保留原数据
+ * @brief 将热点大小的内存块放入快速链表
+ *
+ * @param heap 堆句柄
+ * @param block 已使用的内存块
+ * @return int 1:已放入 0:不是热点大小或链表已满
+ */
+static int mem_quick_push(mem_heap_t *heap, MemBlock *block)
+{
+    int i = mem_quick_index(block_size(block));
+
+    if (i < 0 || heap->quick_count[i] >= MEM_QUICK_DEPTH) {
+        return 0;
+    }
+    block_link(block)->next = heap->quick[i];
+    heap->quick[i] = block;
+    heap->quick_count[i]++;
+#if MEM_STATS
+    heap->stats.free_size += block_size(block);
+    heap->stats.free_blocks++;
+#endif
+    return 1;
+}
+
+/**
+ * @brief 将快速链表中的内存块全部合并回堆
+ *
+ * @param heap 堆句柄
+ * @return int 合并回堆的块数
+ */
+static int mem_quick_flush(mem_heap_t *heap)
+{
+    int i, n = 0;
+    MemBlock *block;
+
+    for (i = 0; i < MEM_QUICK_NUM; i++) {
+        while (heap->quick[i]) {
+            block = heap->quick[i];
+            heap->quick[i] = block_link(block)->next;
+#if MEM_STATS
+            heap->stats.free_size -= block_size(block);
+            heap->stats.free_blocks--;
+#endif
+            block_release(heap, block);
+            n++;
+        }
+        heap->quick_count[i] = 0;
+    }
+    return n;
+}
+#endif
+
+/**
+ * @brief 在一块内存区域上初始化一个独立的堆
+ *
+ * @param heap 堆句柄
+ * @param buf 堆管理的内存区域
+ * @param len 内存区域大小，以Byte为单位，超出单个堆可管理大小的部分不使用
+ * @return int 0:成功  -1:失败
+ */
+int mem_heap_init(mem_heap_t *heap, void *buf, size_t len)
+{
+    MemBlock *block;
+    MemBlock *sentinel;
+    char *start = (char*)MEM_ALIGN_UP((size_t)buf);
+
+    if (!heap || !buf || len < (size_t)(start - (char*)buf) + 2 * MEM_BLOCK_HEADER_SIZE + MEM_BLOCK_SIZE_MIN) {
+        return -1;
+    }
+    len -= start - (char*)buf;
+    if (len > MEM_BLOCK_SIZE_MAX - MEM_ALIGN_SIZE) {
+        len = MEM_BLOCK_SIZE_MAX - MEM_ALIGN_SIZE;
+    }
+
+    memset(heap, 0, sizeof(mem_heap_t));
+    heap->start = start;
+    heap->end = start + MEM_ALIGN_DOWN(len);
+#if MEM_STATS
+    heap->stats.total_size = heap->end - heap->start;
+#endif
+
+    // 整个区域作为一个空闲块，尾部放置一个大小为0、已使用的哨兵块
+    block = (MemBlock*)start;
+    block->size = MEM_ALIGN_DOWN(len - 2 * MEM_BLOCK_HEADER_SIZE);
+    sentinel = block_next_phys(block);
+    sentinel->size = MEM_BLOCK_USED_BIT;
+    block_mark_as_free(block);
+    block_insert(heap, block);
+
+    return 0;
+}
+
+/**
+ * @brief 查找并取出一个不小于size的空闲块
+ *
+ * @param heap 堆句柄
+ * @param size 已对齐的申请大小
+ * @return MemBlock* 已从空闲链表中移除的内存块，NULL表示没有合适的内存块
+ */
+static MemBlock *block_locate_free(mem_heap_t *heap, size_t size)
+{
+    int fl, sl;
+    MemBlock *block;
+
+    // 通过位图定位合适的空闲链表，取链表头即可
+    mapping_search(size, &fl, &sl);
+    block = search_suitable_block(heap, &fl, &sl);
+    if (!block) {
+        // 向上取整后无满足的链表时，再检查size本身所在链表的表头(O(1))，
+        // 避免小内存池中大块申请因取整而失败
+        mapping_insert(size, &fl, &sl);
+        block = heap->blocks[fl][sl];
+        if (!block || block_size(block) < size) {
+#if MEM_QUICK_LIST
+            // 快速链表中暂存的块合并回堆后重试
+            if (mem_quick_flush(heap)) {
+                return block_locate_free(heap, size);
+            }
+#endif
+            return NULL;
+        }
+    }
+    remove_free_block(heap, block, fl, sl);
+    return block;
+}
+
+/**
+ * @brief 从指定堆申请内存
+ *
+ * @param heap 堆句柄
+ * @param size 要申请的内存大小，以Byte为单位
+ * @return void* 申请到的内存的地址(按MEM_ALIGN_SIZE对齐)，NULL表示申请失败
+ */
+void *mem_heap_alloc(mem_heap_t *heap, size_t size)
+{
+    MemBlock *block = NULL;
+    size_t adjust = adjust_request_size(size);
+#if MEM_STATS
+    uint32_t start = MEM_STATS_CYCLES();
+#endif
+
+#if MEM_QUICK_LIST
+    if (adjust) {
+        block = mem_quick_pop(heap, adjust);
+    }
+    if (!block && adjust) {
+#else
+    if (adjust) {
+#endif
+        block = block_locate_free(heap, adjust);
+        if (block) {
+            // 拆分并标记内存块为已使用
+            block_split(heap, block, adjust);
+        }
+    }
+#if MEM_STATS
+    mem_stats_alloc(heap, block, start);
+#endif
+    // 没有找到合适的内存块时返回NULL
+    return block ? block_to_ptr(block) : NULL;
+}
+
+/**
+ * @brief 从指定堆申请按align对齐的内存，用于DMA描述符、cache line对齐的缓冲区等
+ *
+ * @param heap 堆句柄
+ * @param size 要申请的内存大小，以Byte为单位
+ * @param align 对齐字节数，必须为2的幂
+ * @return void* 申请到的内存的地址，NULL表示申请失败
+ * @attention 对齐产生的前部空隙会作为空闲块归还堆；
+ *            mem_realloc扩容时若需要搬移，新地址只保证MEM_ALIGN_SIZE对齐
+ */
+void *mem_heap_alloc_aligned(mem_heap_t *heap, size_t size, size_t align)
+{
+    MemBlock *block, *aligned_block;
+    const size_t gap_min = MEM_BLOCK_HEADER_SIZE + MEM_BLOCK_SIZE_MIN;
+    size_t adjust, gap;
+    char *ptr, *aligned;
+#if MEM_STATS
+    uint32_t start = MEM_STATS_CYCLES();
+#endif
+
+    if (!align || (align & (align - 1))) {
+        return NULL;
+    }
+    if (align <= MEM_ALIGN_SIZE) {
+        return mem_heap_alloc(heap, size);
+    }
+    adjust = adjust_request_size(size);
+    if (!adjust || !adjust_request_size(adjust + align + gap_min)) {
+        return NULL;
+    }
+    // 多申请align + gap_min，保证前部空隙足够拆分成一个独立的空闲块
+    block = block_locate_free(heap, adjust + align + gap_min);
+    if (!block) {
+#if MEM_STATS
+        heap->stats.fail_count++;
+#endif
+        return NULL;
+    }
+
+    ptr = (char*)block_to_ptr(block);
+    aligned = (char*)(((size_t)ptr + (align - 1)) & ~(align - 1));
+    gap = aligned - ptr;
+    if (gap && gap < gap_min) {
+        // 空隙放不下一个内存块，移到下一个对齐地址
+        aligned = (char*)(((size_t)ptr + gap_min + (align - 1)) & ~(align - 1));
+        gap = aligned - ptr;
+    }
+    if (gap) {
+        // 前部空隙拆成空闲块归还
+        aligned_block = block_from_ptr(aligned);
+        aligned_block->size = block_size(block) - gap;
+        block_set_size(block, gap - MEM_BLOCK_HEADER_SIZE);
+        block_mark_as_free(block);
+        block_insert(heap, block);
+        block = aligned_block;
+    }
+    block_split(heap, block, adjust);
+#if MEM_STATS
+    mem_stats_alloc(heap, block, start);
+#endif
+    return block_to_ptr(block);
+}
+
+/**
+ * @brief 释放指定堆中的内存
+ *
+ * @param heap 堆句柄
+ * @param ptr 要释放内存的指针
+ */
+void mem_heap_free(mem_heap_t *heap, void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    MemBlock *curr_block = block_from_ptr(ptr);
+#if MEM_STATS
+    heap->stats.used_size -= block_size(curr_block);
+    heap->stats.free_count++;
+#endif
+#if MEM_QUICK_LIST
+    if (mem_quick_push(heap, curr_block)) {
+        return;
+    }
+#endif
+    block_release(heap, curr_block);
+}
+
+/**
+ * @brief 重新分配指定堆中的内存，保留原数据
  *
+ * @param heap 堆句柄
  * @param ptr 需要重新分配的内存的指针
  * @param size 重新分配的大小
  * @return void* 重新分配后的地址
  */
-void *mem_realloc(void *ptr, size_t size) {
+void *mem_heap_realloc(mem_heap_t *heap, void *ptr, size_t size) {
     if (!ptr) {
         // 如果ptr为NULL，直接分配新的内存块
-        return mem_alloc(size);
+        return mem_heap_alloc(heap, size);
     }
-    MemBlock *curr_block = (MemBlock*)((char*)ptr - sizeof(MemBlock));
-    MemBlock *next_block = curr_block->next;
-    if (size <= curr_block->size) {
-        // 新内存大小小于等于原内存大小，直接返回原内存块指针
+    MemBlock *curr_block = block_from_ptr(ptr);
+    MemBlock *next_block = block_next_phys(curr_block);
+    size_t curr_size = block_size(curr_block);
+    size_t adjust = adjust_request_size(size);
+
+    if (!adjust) {
+        return NULL;
+    }
+    if (adjust <= curr_size) {
+        // 缩小：原地拆分，尾部归还堆
+        block_trim_used(heap, curr_block, adjust);
+#if MEM_STATS
+        heap->stats.used_size -= curr_size - block_size(curr_block);
+#endif
         return ptr;
-    } else if (next_block && !next_block->used && curr_block->size + sizeof(MemBlock) + next_block->size >= size) {
-        // 下一个内存块存在且合并后大小大于等于size，合并内存块并返回原内存块指针
-        mem_free(ptr);
-        mem_alloc(size);
+    } else if (block_is_free(next_block) && curr_size + MEM_BLOCK_HEADER_SIZE + block_size(next_block) >= adjust) {
+        // 扩大：物理上的后一块空闲且足够，原地吸收后再拆分多余部分
+        block_remove(heap, next_block);
+        block_set_size(curr_block, curr_size + MEM_BLOCK_HEADER_SIZE + block_size(next_block));
+        block_mark_as_used(curr_block);
+        block_trim_used(heap, curr_block, adjust);
+#if MEM_STATS
+        heap->stats.used_size += block_size(curr_block) - curr_size;
+        if (heap->stats.used_size > heap->stats.peak_used_size) {
+            heap->stats.peak_used_size = heap->stats.used_size;
+        }
+#endif
         return ptr;
     } else {
         // 分配新内存并拷贝原内存数据
-        void *new_ptr = mem_alloc(size);
+        void *new_ptr = mem_heap_alloc(heap, size);
         if (new_ptr) {
-            memcpy(new_ptr, ptr, curr_block->size);
-            mem_free(ptr);
+            memcpy(new_ptr, ptr, curr_size);
+            mem_heap_free(heap, ptr);
         }
         return new_ptr;
     }
 }
 
+#if MEM_STATS
+/**
+ * @brief 读取指定堆的统计信息
+ *
+ * @param heap 堆句柄
+ * @param stats 统计信息输出
+ */
+void mem_heap_stats(mem_heap_t *heap, mem_stats_t *stats)
+{
+    int fl, sl;
+
+    *stats = heap->stats;
+    stats->largest_free = 0;
+    if (heap->fl_bitmap) {
+        // 最高非空空闲链表的表头
+        fl = mem_fls(heap->fl_bitmap);
+        sl = mem_fls(heap->sl_bitmap[fl]);
+        stats->largest_free = block_size(heap->blocks[fl][sl]);
+    }
+#if MEM_QUICK_LIST
+    // 快速链表中的块申请失败时会合并回堆，与空闲块一并统计
+    for (fl = 0; fl < MEM_QUICK_NUM; fl++) {
+        if (heap->quick[fl] && block_size(heap->quick[fl]) > stats->largest_free) {
+            stats->largest_free = block_size(heap->quick[fl]);
+        }
+    }
+#endif
+    stats->frag_permille = stats->free_size ?
+        (uint32_t)(1000 - (uint64_t)stats->largest_free * 1000 / stats->free_size) : 0;
+}
+#endif
+
+//------------------------------ buddy --------------------------------//
+#if MEM_BUDDY
+/*
+ * 伙伴分配模式：默认堆改为二进制伙伴系统管理，块大小为MEM_BUDDY_MIN_SIZE * 2^order，
+ * 块地址(相对内存池起始)按块大小自然对齐，已分配块没有头部。
+ * 每个order一个空闲链表 + 空闲位图，伙伴块序号为idx ^ (1 << order)，
+ * 拆分/合并最多log2(MEM_SIZE / MEM_BUDDY_MIN_SIZE)次
+ */
+#define MEM_BUDDY_MIN_SIZE (1 << MEM_BUDDY_MIN_LOG2)
+#define MEM_BUDDY_BLOCKS (MEM_SIZE / MEM_BUDDY_MIN_SIZE) // 最小块数量
+// order级序号为idx(以最小块计)的块在位图中的位置，各order依次排列
+#define MEM_BUDDY_BIT(order, idx) (2 * MEM_BUDDY_BLOCKS - 2 * (MEM_BUDDY_BLOCKS >> (order)) + ((idx) >> (order)))
+
+#if MEM_SIZE & (MEM_SIZE - 1)
+#error "MEM_SIZE must be a power of 2 in buddy mode"
+#endif
+#if MEM_BUDDY_MIN_LOG2 < 3 || (UINTPTR_MAX > 0xFFFFFFFFu && MEM_BUDDY_MIN_LOG2 < 4)
+#error "MEM_BUDDY_MIN_SIZE must hold two pointers"
+#endif
+#if MEM_BUDDY_BLOCKS < 1
+#error "MEM_SIZE must not be smaller than MEM_BUDDY_MIN_SIZE"
+#endif
+
+// 空闲链表节点，存放在空闲块起始处
+typedef struct mem_buddy_link {
+    struct mem_buddy_link *next;
+    struct mem_buddy_link *prev;
+} MemBuddyLink;
+
+static MemBuddyLink *mem_buddy_list[MEM_FL_INDEX_MAX]; // 各order的空闲链表头
+static uint32_t mem_buddy_list_map; // bit置位表示该order的空闲链表非空
+static uint32_t mem_buddy_bitmap[(2 * MEM_BUDDY_BLOCKS + 31) / 32]; // 空闲位图
+static uint8_t mem_buddy_order[MEM_BUDDY_BLOCKS]; // 已分配块的order + 1，按块起始的最小块序号索引
+static int mem_buddy_top; // 最大order(整个内存池)
+#if MEM_STATS
+static mem_stats_t mem_buddy_stats_data;
+#endif
+
+static inline MemBuddyLink *buddy_block(size_t idx)
+{
+    return (MemBuddyLink*)((char*)memory_pool + idx * MEM_BUDDY_MIN_SIZE);
+}
+
+static inline size_t buddy_index(const void *ptr)
+{
+    return (size_t)((const char*)ptr - (const char*)memory_pool) / MEM_BUDDY_MIN_SIZE;
+}
+
+static inline int buddy_is_free(int order, size_t idx)
+{
+    size_t bit = MEM_BUDDY_BIT(order, idx);
+    return (mem_buddy_bitmap[bit >> 5] >> (bit & 31)) & 1;
+}
+
+/**
+ * @brief 将空闲块放入order级空闲链表
+ *
+ */
+static void buddy_push(int order, size_t idx)
+{
+    MemBuddyLink *block = buddy_block(idx);
+    size_t bit = MEM_BUDDY_BIT(order, idx);
+
+    block->prev = NULL;
+    block->next = mem_buddy_list[order];
+    if (block->next) {
+        block->next->prev = block;
+    }
+    mem_buddy_list[order] = block;
+    mem_buddy_list_map |= 1u << order;
+    mem_buddy_bitmap[bit >> 5] |= 1u << (bit & 31);
+#if MEM_STATS
+    mem_buddy_stats_data.free_size += (size_t)MEM_BUDDY_MIN_SIZE << order;
+    mem_buddy_stats_data.free_blocks++;
+#endif
+}
+
+/**
+ * @brief 将空闲块从order级空闲链表中移除
+ *
+ */
+static void buddy_remove(int order, size_t idx)
+{
+    MemBuddyLink *block = buddy_block(idx);
+    size_t bit = MEM_BUDDY_BIT(order, idx);
+
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        mem_buddy_list[order] = block->next;
+        if (!block->next) {
+            mem_buddy_list_map &= ~(1u << order);
+        }
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+    mem_buddy_bitmap[bit >> 5] &= ~(1u << (bit & 31));
+#if MEM_STATS
+    mem_buddy_stats_data.free_size -= (size_t)MEM_BUDDY_MIN_SIZE << order;
+    mem_buddy_stats_data.free_blocks--;
+#endif
+}
+
+/**
+ * @brief 计算容纳size所需的最小order
+ *
+ * @param size 申请大小
+ * @return int order，-1表示超出内存池大小
+ */
+static int buddy_size_to_order(size_t size)
+{
+    int order;
+
+    if (size <= MEM_BUDDY_MIN_SIZE) {
+        return 0;
+    }
+    if (size > MEM_SIZE) {
+        return -1;
+    }
+    order = mem_fls((uint32_t)(size - 1)) + 1 - MEM_BUDDY_MIN_LOG2;
+    return order;
+}
+
+/**
+ * @brief 初始化伙伴分配器，整个内存池作为一个最大order的空闲块
+ *
+ */
+static void mem_buddy_init(void)
+{
+    memset(mem_buddy_list, 0, sizeof(mem_buddy_list));
+    memset(mem_buddy_bitmap, 0, sizeof(mem_buddy_bitmap));
+    memset(mem_buddy_order, 0, sizeof(mem_buddy_order));
+    mem_buddy_list_map = 0;
+    mem_buddy_top = mem_fls(MEM_BUDDY_BLOCKS);
+#if MEM_STATS
+    memset(&mem_buddy_stats_data, 0, sizeof(mem_buddy_stats_data));
+    mem_buddy_stats_data.total_size = MEM_SIZE;
+#endif
+    buddy_push(mem_buddy_top, 0);
+}
+
+/**
+ * @brief 伙伴分配器申请内存
+ *
+ * @param size 要申请的内存大小，以Byte为单位
+ * @return void* 申请到的内存地址(相对内存池按块大小对齐)，NULL表示申请失败
+ */
+static void *mem_buddy_alloc(size_t size)
+{
+    int order = buddy_size_to_order(size);
+    int k;
+    uint32_t map;
+    size_t idx;
+#if MEM_STATS
+    uint32_t start = MEM_STATS_CYCLES();
+    uint32_t cycles;
+    int bin;
+#endif
+
+    map = order < 0 ? 0 : mem_buddy_list_map & ~((1u << order) - 1);
+    if (!map) {
+#if MEM_STATS
+        mem_buddy_stats_data.fail_count++;
+#endif
+        return NULL;
+    }
+    // 不小于order的最小非空链表
+    k = mem_ffs(map);
+    idx = buddy_index(mem_buddy_list[k]);
+    buddy_remove(k, idx);
+    // 逐级对半拆分，高地址一半放回低一级链表
+    while (k > order) {
+        k--;
+        buddy_push(k, idx + ((size_t)1 << k));
+    }
+    mem_buddy_order[idx] = (uint8_t)(order + 1);
+#if MEM_STATS
+    cycles = MEM_STATS_CYCLES() - start;
+    bin = cycles ? mem_fls(cycles) : 0;
+    mem_buddy_stats_data.alloc_count++;
+    mem_buddy_stats_data.used_size += (size_t)MEM_BUDDY_MIN_SIZE << order;
+    if (mem_buddy_stats_data.used_size > mem_buddy_stats_data.peak_used_size) {
+        mem_buddy_stats_data.peak_used_size = mem_buddy_stats_data.used_size;
+    }
+    mem_buddy_stats_data.alloc_hist[bin < MEM_STATS_HIST_BINS ? bin : MEM_STATS_HIST_BINS - 1]++;
+#endif
+    return buddy_block(idx);
+}
+
+/**
+ * @brief 伙伴分配器释放内存，与空闲的伙伴块逐级合并
+ *
+ * @param ptr 要释放内存的指针
+ */
+static void mem_buddy_free(void *ptr)
+{
+    size_t idx, buddy;
+    int order;
+
+    if (!ptr || (char*)ptr < (char*)memory_pool || (char*)ptr >= (char*)memory_pool + MEM_SIZE) {
+        return;
+    }
+    idx = buddy_index(ptr);
+    if (!mem_buddy_order[idx]) {
+        return;
+    }
+    order = mem_buddy_order[idx] - 1;
+    mem_buddy_order[idx] = 0;
+#if MEM_STATS
+    mem_buddy_stats_data.used_size -= (size_t)MEM_BUDDY_MIN_SIZE << order;
+    mem_buddy_stats_data.free_count++;
+#endif
+    while (order < mem_buddy_top) {
+        buddy = idx ^ ((size_t)1 << order);
+        if (!buddy_is_free(order, buddy)) {
+            break;
+        }
+        buddy_remove(order, buddy);
+        idx &= ~((size_t)1 << order);
+        order++;
+    }
+    buddy_push(order, idx);
+}
+
+/**
+ * @brief 伙伴分配器申请按align对齐的内存
+ *
+ * @param size 要申请的内存大小，以Byte为单位
+ * @param align 对齐字节数，必须为2的幂
+ * @return void* 申请到的内存的地址，NULL表示申请失败
+ * @attention 块按自身大小相对内存池起始对齐，申请max(size, align)即可满足对齐，
+ *            内存池本身未按align对齐时返回NULL
+ */
+static void *mem_buddy_alloc_aligned(size_t size, size_t align)
+{
+    void *ptr;
+
+    if (!align || (align & (align - 1))) {
+        return NULL;
+    }
+    ptr = mem_buddy_alloc(size > align ? size : align);
+    if (ptr && ((size_t)ptr & (align - 1))) {
+        mem_buddy_free(ptr);
+        ptr = NULL;
+    }
+    return ptr;
+}
+
+/**
+ * @brief 伙伴分配器重新分配内存，保留原数据
+ *
+ * @param ptr 需要重新分配的内存的指针
+ * @param size 重新分配的大小
+ * @return void* 重新分配后的地址
+ */
+static void *mem_buddy_realloc(void *ptr, size_t size)
+{
+    size_t curr_size;
+    void *new_ptr;
+
+    if (!ptr) {
+        return mem_buddy_alloc(size);
+    }
+    curr_size = (size_t)MEM_BUDDY_MIN_SIZE << (mem_buddy_order[buddy_index(ptr)] - 1);
+    if (size <= curr_size && size > curr_size / 2) {
+        // 仍属于同一order，原地返回
+        return ptr;
+    }
+    new_ptr = mem_buddy_alloc(size);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, size < curr_size ? size : curr_size);
+        mem_buddy_free(ptr);
+    } else if (size <= curr_size) {
+        // 缩小时申请失败，保留原内存
+        return ptr;
+    }
+    return new_ptr;
+}
+
+#if MEM_STATS
+/**
+ * @brief 读取伙伴分配器的统计信息
+ *
+ * @param stats 统计信息输出
+ */
+static void mem_buddy_stats(mem_stats_t *stats)
+{
+    *stats = mem_buddy_stats_data;
+    stats->largest_free = mem_buddy_list_map ? (size_t)MEM_BUDDY_MIN_SIZE << mem_fls(mem_buddy_list_map) : 0;
+    stats->frag_permille = stats->free_size ?
+        (uint32_t)(1000 - (uint64_t)stats->largest_free * 1000 / stats->free_size) : 0;
+}
+#endif
+
+#define mem_backend_init() mem_buddy_init()
+#define mem_backend_alloc(size) mem_buddy_alloc(size)
+#define mem_backend_alloc_aligned(size, align) mem_buddy_alloc_aligned(size, align)
+#define mem_backend_free(ptr) mem_buddy_free(ptr)
+#define mem_backend_realloc(ptr, size) mem_buddy_realloc(ptr, size)
+#define mem_backend_stats(stats) mem_buddy_stats(stats)
+#define MEM_BACKEND_START ((char*)memory_pool)
+#define MEM_BACKEND_SIZE MEM_SIZE
+#else
+#define mem_backend_init() mem_heap_init(&mem_default_heap, memory_pool, sizeof(memory_pool))
+#define mem_backend_alloc(size) mem_heap_alloc(&mem_default_heap, size)
+#define mem_backend_alloc_aligned(size, align) mem_heap_alloc_aligned(&mem_default_heap, size, align)
+#define mem_backend_free(ptr) mem_heap_free(&mem_default_heap, ptr)
+#define mem_backend_realloc(ptr, size) mem_heap_realloc(&mem_default_heap, ptr, size)
+#define mem_backend_stats(stats) mem_heap_stats(&mem_default_heap, stats)
+#define MEM_BACKEND_START (mem_default_heap.start)
+#define MEM_BACKEND_SIZE (mem_default_heap.end - mem_default_heap.start)
+#endif /* MEM_BUDDY */
+
+//------------------------------ isr safe --------------------------------//
+#if MEM_ISR_SAFE
+/*
+ * 默认堆的中断安全模式：
+ * 1. 堆锁：线程上下文获取，中断上下文只尝试获取，失败则走缓存，不会屏蔽中断也不会死等
+ * 2. 中断缓存：由线程上下文预先从堆中申请MEM_MAG_BLOCK_SIZE大小的块填充，
+ *    中断中申请不大于MEM_MAG_BLOCK_SIZE的内存时通过原子操作直接取出
+ * 3. 线程缓存：线程上下文释放的同尺寸块暂存于此，用于补充中断缓存和线程的小块申请
+ * 4. 延迟释放：中断中释放的内存通过原子操作压入无锁链表，由线程上下文回收到堆
+ */
+#include <stdatomic.h>
+
+#ifndef MEM_IN_ISR
+#if defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+static inline int mem_in_isr(void)
+{
+    uint32_t ipsr;
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    return ipsr != 0;
+}
+#define MEM_IN_ISR() mem_in_isr()
+#else
+#define MEM_IN_ISR() 0
+#endif
+#endif
+
+#define MEM_MAG_MASK (MEM_MAG_DEPTH - 1)
+
+#if MEM_MAG_DEPTH & MEM_MAG_MASK
+#error "MEM_MAG_DEPTH must be a power of 2"
+#endif
+
+// 中断缓存：单生产者(线程上下文) 多消费者(各优先级中断)
+typedef struct mem_magazine {
+    _Atomic(void*) slot[MEM_MAG_DEPTH]; // 被抢占的消费者可能读到正在复用的槽，CAS失败后丢弃，故使用原子访问
+    atomic_uint head; // 消费者写
+    atomic_uint tail; // 生产者写
+} MemMagazine;
+
+static atomic_flag mem_heap_lock_flag = ATOMIC_FLAG_INIT; // 默认堆的锁
+static MemMagazine mem_isr_mag; // 中断缓存
+static void *mem_thread_mag[MEM_MAG_DEPTH]; // 线程缓存，持锁访问
+static unsigned int mem_thread_mag_cnt = 0;
+static _Atomic(void*) mem_deferred_free = NULL; // 中断中释放、待回收的内存链表
+
+static inline void mem_heap_lock(void)
+{
+    while (atomic_flag_test_and_set_explicit(&mem_heap_lock_flag, memory_order_acquire)) {
+    }
+}
+
+static inline int mem_heap_try_lock(void)
+{
+    return !atomic_flag_test_and_set_explicit(&mem_heap_lock_flag, memory_order_acquire);
+}
+
+static inline void mem_heap_unlock(void)
+{
+    atomic_flag_clear_explicit(&mem_heap_lock_flag, memory_order_release);
+}
+
+/**
+ * @brief 判断内存块能否放入缓存(大小不小于缓存块大小且未超出一个可拆分的余量)
+ *
+ * @param ptr 内存指针
+ * @return int 1:可以  0:不可以
+ */
+static int mem_mag_fit(void *ptr)
+{
+#if MEM_BUDDY
+    return mem_buddy_order[buddy_index(ptr)] == buddy_size_to_order(MEM_MAG_BLOCK_SIZE) + 1;
+#else
+    size_t size = block_size(block_from_ptr(ptr));
+    return size >= MEM_ALIGN_UP(MEM_MAG_BLOCK_SIZE)
+        && size < MEM_ALIGN_UP(MEM_MAG_BLOCK_SIZE) + MEM_BLOCK_HEADER_SIZE + MEM_BLOCK_SIZE_MIN;
+#endif
+}
+
+/**
+ * @brief 中断缓存取出一块，可在任意中断优先级中调用
+ *
+ * @return void* 内存指针，NULL表示缓存为空
+ */
+static void *mem_isr_mag_pop(void)
+{
+    unsigned int head = atomic_load_explicit(&mem_isr_mag.head, memory_order_relaxed);
+    void *ptr;
+
+    do {
+        if (head == atomic_load_explicit(&mem_isr_mag.tail, memory_order_acquire)) {
+            return NULL;
+        }
+        ptr = atomic_load_explicit(&mem_isr_mag.slot[head & MEM_MAG_MASK], memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&mem_isr_mag.head, &head, head + 1,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+    return ptr;
+}
+
+/**
+ * @brief 中断缓存放入一块，只在持锁的线程上下文中调用
+ *
+ * @param ptr 内存指针
+ * @return int 1:成功  0:缓存已满
+ */
+static int mem_isr_mag_push(void *ptr)
+{
+    unsigned int tail = atomic_load_explicit(&mem_isr_mag.tail, memory_order_relaxed);
+
+    if (tail - atomic_load_explicit(&mem_isr_mag.head, memory_order_acquire) >= MEM_MAG_DEPTH) {
+        return 0;
+    }
+    atomic_store_explicit(&mem_isr_mag.slot[tail & MEM_MAG_MASK], ptr, memory_order_relaxed);
+    atomic_store_explicit(&mem_isr_mag.tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/**
+ * @brief 中断缓存是否已满，只在持锁的线程上下文中调用
+ *
+ * @return int 1:已满  0:未满
+ */
+static int mem_isr_mag_full(void)
+{
+    unsigned int tail = atomic_load_explicit(&mem_isr_mag.tail, memory_order_relaxed);
+    return tail - atomic_load_explicit(&mem_isr_mag.head, memory_order_acquire) >= MEM_MAG_DEPTH;
+}
+
+/**
+ * @brief 中断中释放内存，压入延迟释放链表
+ *
+ * @param ptr 内存指针
+ */
+static void mem_deferred_push(void *ptr)
+{
+    void *head = atomic_load_explicit(&mem_deferred_free, memory_order_relaxed);
+    do {
+        *(void**)ptr = head;
+    } while (!atomic_compare_exchange_weak_explicit(&mem_deferred_free, &head, ptr,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+/**
+ * @brief 线程上下文释放内存(已持锁)，同尺寸块优先放入缓存
+ *
+ * @param ptr 内存指针
+ */
+static void mem_thread_free_locked(void *ptr)
+{
+    if (mem_mag_fit(ptr)) {
+        if (mem_isr_mag_push(ptr)) {
+            return;
+        }
+        if (mem_thread_mag_cnt < MEM_MAG_DEPTH) {
+            mem_thread_mag[mem_thread_mag_cnt++] = ptr;
+            return;
+        }
+    }
+    mem_backend_free(ptr);
+}
+
+/**
+ * @brief 回收中断中释放的内存并补充中断缓存(已持锁)
+ *
+ */
+static void mem_service_locked(void)
+{
+    void *ptr = atomic_exchange_explicit(&mem_deferred_free, NULL, memory_order_acquire);
+    void *next;
+
+    while (ptr) {
+        next = *(void**)ptr;
+        mem_thread_free_locked(ptr);
+        ptr = next;
+    }
+    // 补满中断缓存，优先使用线程缓存中的块
+    while (!mem_isr_mag_full()) {
+        if (mem_thread_mag_cnt) {
+            ptr = mem_thread_mag[--mem_thread_mag_cnt];
+        } else {
+            ptr = mem_backend_alloc(MEM_MAG_BLOCK_SIZE);
+            if (!ptr) {
+                break;
+            }
+        }
+        mem_isr_mag_push(ptr);
+    }
+}
+
+/**
+ * @brief 将缓存中的块全部归还堆(已持锁)，用于堆空间不足时
+ *
+ */
+static void mem_mag_flush_locked(void)
+{
+    void *ptr;
+
+    while (mem_thread_mag_cnt) {
+        mem_backend_free(mem_thread_mag[--mem_thread_mag_cnt]);
+    }
+    while ((ptr = mem_isr_mag_pop()) != NULL) {
+        mem_backend_free(ptr);
+    }
+}
+
+/**
+ * @brief 回收中断中释放的内存，并补充中断缓存
+ * @attention 在线程上下文调用，可放在主循环空闲时执行，
+ *            mem_alloc/mem_free等在线程上下文调用时也会自动执行
+ */
+void mem_service(void)
+{
+    if (MEM_IN_ISR()) {
+        return;
+    }
+    mem_heap_lock();
+    mem_service_locked();
+    mem_heap_unlock();
+}
+#endif /* MEM_ISR_SAFE */
+
+/**
+ * @brief 初始化内存申请内存池
+ *
+ */
+void mem_init(void)
+{
+    mem_backend_init();
+#if MEM_ISR_SAFE
+    atomic_store(&mem_isr_mag.head, 0);
+    atomic_store(&mem_isr_mag.tail, 0);
+    atomic_store(&mem_deferred_free, NULL);
+    mem_thread_mag_cnt = 0;
+    mem_service_locked();
+#endif
+}
+
+/**
+ * @brief 从默认堆申请内存
+ *
+ * @param size 要申请的内存大小，以Byte为单位
+ * @return void* 申请到的内存的地址，NULL表示申请失败
+ */
+static void *mem_default_alloc(size_t size)
+{
+#if MEM_ISR_SAFE
+    void *ptr = NULL;
+
+    if (MEM_IN_ISR()) {
+        // 中断中：小块从中断缓存取，否则只在堆空闲时申请
+        if (size <= MEM_MAG_BLOCK_SIZE) {
+            ptr = mem_isr_mag_pop();
+        }
+        if (!ptr && mem_heap_try_lock()) {
+            ptr = mem_backend_alloc(size);
+            mem_heap_unlock();
+        }
+        return ptr;
+    }
+    mem_heap_lock();
+    mem_service_locked();
+    if (size <= MEM_MAG_BLOCK_SIZE && mem_thread_mag_cnt) {
+        ptr = mem_thread_mag[--mem_thread_mag_cnt];
+    } else {
+        ptr = mem_backend_alloc(size);
+        if (!ptr) {
+            // 堆空间不足，归还缓存后重试
+            mem_mag_flush_locked();
+            ptr = mem_backend_alloc(size);
+        }
+    }
+    mem_heap_unlock();
+    return ptr;
+#else
+    return mem_backend_alloc(size);
+#endif
+}
+
+/**
+ * @brief 从默认堆申请按align对齐的内存
+ *
+ * @param size 要申请的内存大小，以Byte为单位
+ * @param align 对齐字节数，必须为2的幂
+ * @return void* 申请到的内存的地址，NULL表示申请失败
+ */
+static void *mem_default_alloc_aligned(size_t size, size_t align)
+{
+#if MEM_ISR_SAFE
+    void *ptr = NULL;
+
+    if (MEM_IN_ISR()) {
+        if (mem_heap_try_lock()) {
+            ptr = mem_backend_alloc_aligned(size, align);
+            mem_heap_unlock();
+        }
+        return ptr;
+    }
+    mem_heap_lock();
+    ptr = mem_backend_alloc_aligned(size, align);
+    if (!ptr) {
+        mem_mag_flush_locked();
+        ptr = mem_backend_alloc_aligned(size, align);
+    }
+    mem_heap_unlock();
+    return ptr;
+#else
+    return mem_backend_alloc_aligned(size, align);
+#endif
+}
+
+/**
+ * @brief 释放默认堆中的内存
+ *
+ * @param ptr 要释放内存的指针
+ */
+static void mem_default_free(void *ptr)
+{
+#if MEM_ISR_SAFE
+    if (!ptr) {
+        return;
+    }
+    if (MEM_IN_ISR()) {
+        // 中断中只压入延迟释放链表，由线程上下文回收
+        mem_deferred_push(ptr);
+        return;
+    }
+    mem_heap_lock();
+    mem_thread_free_locked(ptr);
+    mem_service_locked();
+    mem_heap_unlock();
+#else
+    mem_backend_free(ptr);
+#endif
+}
+
+/**
+ * @brief 重新分配默认堆中的内存，保留原数据
+ *
+ * @param ptr 需要重新分配的内存的指针
+ * @param size 重新分配的大小
+ * @return void* 重新分配后的地址
+ */
+static void *mem_default_realloc(void *ptr, size_t size)
+{
+#if MEM_ISR_SAFE
+    void *new_ptr = NULL;
+
+    if (MEM_IN_ISR()) {
+        if (mem_heap_try_lock()) {
+            new_ptr = mem_backend_realloc(ptr, size);
+            mem_heap_unlock();
+        }
+        return new_ptr;
+    }
+    mem_heap_lock();
+    mem_service_locked();
+    new_ptr = mem_backend_realloc(ptr, size);
+    if (!new_ptr && size) {
+        mem_mag_flush_locked();
+        new_ptr = mem_backend_realloc(ptr, size);
+    }
+    mem_heap_unlock();
+    return new_ptr;
+#else
+    return mem_backend_realloc(ptr, size);
+#endif
+}
+
+//------------------------------ trace --------------------------------//
+#if MEM_TRACE
+#ifndef MEM_TRACE_TIME
+#if MEM_STATS
+#define MEM_TRACE_TIME() MEM_STATS_CYCLES()
+#else
+#define MEM_TRACE_TIME() 0u
+#endif
+#endif
+
+static mem_trace_event_t mem_trace_buf[MEM_TRACE_DEPTH]; // 事件缓冲区，满后停止记录
+static volatile uint32_t mem_trace_cnt = 0; // 已记录的事件数
+static volatile uint32_t mem_trace_dropped = 0; // 缓冲区满后丢弃的事件数
+static volatile uint8_t mem_trace_enable = 0;
+static volatile uint8_t mem_trace_tag = 0; // 当前调用者标记
+
+/**
+ * @brief 内存指针转换为相对默认堆起始的偏移
+ *
+ * @param ptr 内存指针
+ * @return uint32_t 偏移，NULL对应MEM_TRACE_NULL
+ */
+static uint32_t mem_trace_offset(const void *ptr)
+{
+    return ptr ? (uint32_t)((const char*)ptr - MEM_BACKEND_START) : MEM_TRACE_NULL;
+}
+
+/**
+ * @brief 记录一个事件
+ *
+ * @param type 事件类型
+ * @param size 申请大小
+ * @param ptr 返回的内存指针
+ * @param arg free/realloc为原内存偏移，对齐申请为对齐字节数
+ */
+static void mem_trace_record(mem_trace_type_e type, size_t size, const void *ptr, uint32_t arg)
+{
+    uint32_t idx;
+    mem_trace_event_t *event;
+
+    if (!mem_trace_enable) {
+        return;
+    }
+#if MEM_ISR_SAFE
+    idx = __atomic_fetch_add(&mem_trace_cnt, 1, __ATOMIC_RELAXED);
+#else
+    idx = mem_trace_cnt++;
+#endif
+    if (idx >= MEM_TRACE_DEPTH) {
+#if MEM_ISR_SAFE
+        // 与中断中的记录并发，计数同样用原子操作
+        __atomic_store_n(&mem_trace_cnt, MEM_TRACE_DEPTH, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&mem_trace_dropped, 1, __ATOMIC_RELAXED);
+#else
+        mem_trace_cnt = MEM_TRACE_DEPTH;
+        mem_trace_dropped++;
+#endif
+        return;
+    }
+    event = &mem_trace_buf[idx];
+    event->time = MEM_TRACE_TIME();
+    event->size = (uint32_t)size;
+    event->offset = mem_trace_offset(ptr);
+    event->arg = arg;
+    event->type = (uint8_t)type;
+    event->tag = mem_trace_tag;
+    event->reserved = 0;
+}
+
+/**
+ * @brief 清空缓冲区并开始记录
+ *
+ */
+void mem_trace_start(void)
+{
+    mem_trace_enable = 0;
+    mem_trace_cnt = 0;
+    mem_trace_dropped = 0;
+    mem_trace_enable = 1;
+}
+
+/**
+ * @brief 停止记录
+ *
+ */
+void mem_trace_stop(void)
+{
+    mem_trace_enable = 0;
+}
+
+/**
+ * @brief 设置后续事件的调用者标记
+ *
+ * @param tag 调用者标记
+ */
+void mem_trace_set_tag(uint8_t tag)
+{
+    mem_trace_tag = tag;
+}
+
+/**
+ * @brief 输出记录的事件：mem_trace_header_t + count个mem_trace_event_t(小端)
+ *
+ * @param write 输出函数，如串口发送
+ * @attention 输出期间停止记录，输出完成后需要重新调用mem_trace_start
+ */
+void mem_trace_dump(void (*write)(const uint8_t *buf, size_t len))
+{
+    mem_trace_header_t header;
+
+    mem_trace_enable = 0;
+    header.magic = MEM_TRACE_MAGIC;
+    header.version = MEM_TRACE_VERSION;
+    header.event_size = sizeof(mem_trace_event_t);
+    header.heap_size = (uint32_t)(MEM_BACKEND_SIZE);
+    header.count = mem_trace_cnt < MEM_TRACE_DEPTH ? mem_trace_cnt : MEM_TRACE_DEPTH;
+    header.dropped = mem_trace_dropped;
+    write((const uint8_t*)&header, sizeof(header));
+    write((const uint8_t*)mem_trace_buf, header.count * sizeof(mem_trace_event_t));
+}
+#endif /* MEM_TRACE */
+
+//------------------------------ quota --------------------------------//
+#if MEM_QUOTA
+/*
+ * 分标记配额：每次申请带一个标记(子系统)，按内存块实际大小计入该标记的用量，
+ * 超出配额的申请直接失败，保证其他子系统的可用空间。
+ * 内存块的标记按块起始地址记录在owner表中，释放时O(1)查回
+ */
+#if MEM_BUDDY
+#define MEM_QUOTA_GRANULE MEM_BUDDY_MIN_SIZE
+#define mem_backend_block_size(ptr) ((size_t)MEM_BUDDY_MIN_SIZE << (mem_buddy_order[buddy_index(ptr)] - 1))
+#else
+#define MEM_QUOTA_GRANULE MEM_ALIGN_SIZE
+#define mem_backend_block_size(ptr) block_size(block_from_ptr(ptr))
+#endif
+
+/**
+ * @brief 申请size字节时内存块实际大小的上限
+ * @attention 伙伴分配器为size所在order的块大小；TLSF为对齐后的大小加上不足以拆分的剩余部分
+ *
+ * @param size 申请的大小
+ * @return size_t 内存块大小上限，0表示超出范围
+ */
+static size_t mem_backend_block_size_max(size_t size)
+{
+#if MEM_BUDDY
+    int order = buddy_size_to_order(size);
+
+    return order < 0 ? 0 : (size_t)MEM_BUDDY_MIN_SIZE << order;
+#else
+    size_t adjust = adjust_request_size(size);
+
+    return adjust ? adjust + MEM_BLOCK_HEADER_SIZE + MEM_BLOCK_SIZE_MIN - MEM_ALIGN_SIZE : 0;
+#endif
+}
+
+#if MEM_ISR_SAFE
+#define mem_quota_add(p, n) __atomic_add_fetch(p, n, __ATOMIC_RELAXED)
+#define mem_quota_sub(p, n) ((void)__atomic_sub_fetch(p, n, __ATOMIC_RELAXED))
+#else
+#define mem_quota_add(p, n) (*(p) += (n))
+#define mem_quota_sub(p, n) ((void)(*(p) -= (n)))
+#endif
+
+/**
+ * @brief 更新用量峰值
+ *
+ * @param peak 峰值
+ * @param used 当前用量
+ */
+static inline void mem_quota_peak(size_t *peak, size_t used)
+{
+#if MEM_ISR_SAFE
+    size_t old = __atomic_load_n(peak, __ATOMIC_RELAXED);
+
+    while (used > old && !__atomic_compare_exchange_n(peak, &old, used, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+#else
+    if (used > *peak) {
+        *peak = used;
+    }
+#endif
+}
+
+static mem_quota_t mem_quotas[MEM_QUOTA_TAGS]; // 各标记的配额与用量
+static uint8_t mem_quota_owner[MEM_SIZE / MEM_QUOTA_GRANULE]; // 已分配块的标记，按块起始地址索引
+
+static inline uint8_t *mem_quota_owner_of(const void *ptr)
+{
+    return &mem_quota_owner[(size_t)((const char*)ptr - MEM_BACKEND_START) / MEM_QUOTA_GRANULE];
+}
+
+/**
+ * @brief 计入用量，超出配额时撤销
+ *
+ * @param quota 配额
+ * @param size 计入的大小
+ * @return int 1:成功 0:超出配额
+ */
+static int mem_quota_charge(mem_quota_t *quota, size_t size)
+{
+    size_t used = mem_quota_add(&quota->used, size);
+
+    if (quota->limit && used > quota->limit) {
+        mem_quota_sub(&quota->used, size);
+        mem_quota_add(&quota->fail_count, 1);
+        return 0;
+    }
+    mem_quota_peak(&quota->peak, used);
+    return 1;
+}
+
+/**
+ * @brief 设置标记的配额
+ *
+ * @param tag 标记，小于MEM_QUOTA_TAGS
+ * @param limit 配额，以Byte为单位(按内存块实际大小计)，0表示不限制
+ */
+void mem_quota_set(uint8_t tag, size_t limit)
+{
+    if (tag < MEM_QUOTA_TAGS) {
+        mem_quotas[tag].limit = limit;
+    }
+}
+
+/**
+ * @brief 读取标记的配额与用量
+ *
+ * @param tag 标记，小于MEM_QUOTA_TAGS
+ * @param quota 输出
+ */
+void mem_quota_get(uint8_t tag, mem_quota_t *quota)
+{
+    if (tag < MEM_QUOTA_TAGS) {
+        *quota = mem_quotas[tag];
+    }
+}
+#endif /* MEM_QUOTA */
+
+/**
+ * @brief 申请内存：检查配额、申请、记录事件
+ *
+ * @param tag 标记
+ * @param size 要申请的内存大小，以Byte为单位
+ * @param align 对齐字节数，0表示不指定
+ * @return void* 申请到的内存的地址，NULL表示申请失败
+ */
+static void *mem_alloc_internal(uint8_t tag, size_t size, size_t align)
+{
+    void *ptr = NULL;
+
+#if MEM_QUOTA
+    // 先按申请大小预占，申请后改为按内存块实际大小计
+    if (tag < MEM_QUOTA_TAGS && mem_quota_charge(&mem_quotas[tag], size)) {
+        ptr = align ? mem_default_alloc_aligned(size, align) : mem_default_alloc(size);
+        mem_quota_sub(&mem_quotas[tag].used, size);
+        if (ptr && !mem_quota_charge(&mem_quotas[tag], mem_backend_block_size(ptr))) {
+            mem_default_free(ptr);
+            ptr = NULL;
+        }
+        if (ptr) {
+            *mem_quota_owner_of(ptr) = tag;
+        }
+    }
+#else
+    (void)tag;
+    ptr = align ? mem_default_alloc_aligned(size, align) : mem_default_alloc(size);
+#endif
+#if MEM_TRACE
+    if (align) {
+        mem_trace_record(MEM_TRACE_ALLOC_ALIGNED, size, ptr, (uint32_t)align);
+    } else {
+        mem_trace_record(MEM_TRACE_ALLOC, size, ptr, 0);
+    }
+#endif
+    return ptr;
+}
+
+/**
+ * @brief 内存申请
+ *
+ * @param size 要申请的内存大小，以Byte为单位
+ * @return void* 申请到的内存的地址，NULL表示申请失败
+ */
+void *mem_alloc(size_t size)
+{
+    return mem_alloc_internal(MEM_QUOTA_TAG_DEFAULT, size, 0);
+}
+
+/**
+ * @brief 申请按align对齐的内存
+ *
+ * @param size 要申请的内存大小，以Byte为单位
+ * @param align 对齐字节数，必须为2的幂
+ * @return void* 申请到的内存的地址，NULL表示申请失败
+ */
+void *mem_alloc_aligned(size_t size, size_t align)
+{
+    if (!align) {
+        return NULL;
+    }
+    return mem_alloc_internal(MEM_QUOTA_TAG_DEFAULT, size, align);
+}
+
+#if MEM_QUOTA
+/**
+ * @brief 以指定标记申请内存，计入该标记的配额
+ *
+ * @param tag 标记，小于MEM_QUOTA_TAGS
+ * @param size 要申请的内存大小，以Byte为单位
+ * @return void* 申请到的内存的地址，NULL表示申请失败或超出配额
+ */
+void *mem_alloc_tag(uint8_t tag, size_t size)
+{
+    return mem_alloc_internal(tag, size, 0);
+}
+
+/**
+ * @brief 以指定标记申请按align对齐的内存，计入该标记的配额
+ *
+ * @param tag 标记，小于MEM_QUOTA_TAGS
+ * @param size 要申请的内存大小，以Byte为单位
+ * @param align 对齐字节数，必须为2的幂
+ * @return void* 申请到的内存的地址，NULL表示申请失败或超出配额
+ */
+void *mem_alloc_aligned_tag(uint8_t tag, size_t size, size_t align)
+{
+    if (!align) {
+        return NULL;
+    }
+    return mem_alloc_internal(tag, size, align);
+}
+#endif
+
+/**
+ * @brief 内存释放
+ *
+ * @param ptr 要释放内存的指针
+ */
+void mem_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+#if MEM_TRACE
+    mem_trace_record(MEM_TRACE_FREE, 0, NULL, mem_trace_offset(ptr));
+#endif
+#if MEM_QUOTA
+    mem_quota_sub(&mem_quotas[*mem_quota_owner_of(ptr)].used, mem_backend_block_size(ptr));
+#endif
+    mem_default_free(ptr);
+}
+
+/**
+ * @brief 重新分配内存，保留原数据
+ *
+ * @param ptr 需要重新分配的内存的指针
+ * @param size 重新分配的大小
+ * @return void* 重新分配后的地址，NULL表示失败，原内存及其数据不变
+ * @attention 中断安全模式下，在中断中调用时若堆正被占用则返回NULL；
+ *            配额模式下新内存沿用原内存的标记，按新内存块取整后可能的最大大小检查配额，超出时返回NULL
+ */
+void *mem_realloc(void *ptr, size_t size)
+{
+    void *new_ptr;
+#if MEM_TRACE
+    uint32_t old_offset = mem_trace_offset(ptr);
+#endif
+#if MEM_QUOTA
+    mem_quota_t *quota;
+    uint8_t tag;
+    size_t old_size, new_size, max_size, reserve;
+
+    if (!ptr) {
+        return mem_alloc(size);
+    }
+    tag = *mem_quota_owner_of(ptr);
+    quota = &mem_quotas[tag];
+    old_size = mem_backend_block_size(ptr);
+    max_size = mem_backend_block_size_max(size);
+    // 调整前按新内存块可能的最大大小预占扩大部分，超出配额时不调整，原内存不变
+    reserve = max_size > old_size ? max_size - old_size : 0;
+    if (!max_size || !mem_quota_charge(quota, reserve)) {
+        new_ptr = NULL;
+    } else {
+        new_ptr = mem_default_realloc(ptr, size);
+        new_size = old_size;
+        if (new_ptr) {
+            new_size = mem_backend_block_size(new_ptr);
+            *mem_quota_owner_of(new_ptr) = tag;
+        }
+        // 改为按新内存块实际大小计，new_size不超过old_size + reserve
+        mem_quota_sub(&quota->used, old_size + reserve - new_size);
+    }
+#else
+    new_ptr = mem_default_realloc(ptr, size);
+#endif
+#if MEM_TRACE
+    mem_trace_record(MEM_TRACE_REALLOC, size, new_ptr, old_offset);
+#endif
+    return new_ptr;
+}
+
+#if MEM_STATS
+/**
+ * @brief 读取默认堆的统计信息
+ *
+ * @param stats 统计信息输出
+ */
+void mem_stats(mem_stats_t *stats)
+{
+#if MEM_ISR_SAFE
+    if (MEM_IN_ISR()) {
+        mem_backend_stats(stats);
+        return;
+    }
+    mem_heap_lock();
+    mem_backend_stats(stats);
+    mem_heap_unlock();
+#else
+    mem_backend_stats(stats);
+#endif
+}
+#endif
@@ -2,7 +2,7 @@
  * @file mem_malloc.h
  * @author h
  * @brief 静态内存池方式实现的内存malloc free memory
- * @version 0.1
+ * @version 0.2
  * @date 2023-03-22
  *
  * @copyright Copyright (c) 2023
@@ -14,10 +14,224 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------ config ---------------------------------//
+#ifndef MEM_SIZE
+#define MEM_SIZE 1024 // 默认堆(mem_alloc等接口使用)的内存池大小
+#endif
+
+#ifndef MEM_BUDDY
+#define MEM_BUDDY 0 // 1:默认堆改用伙伴分配器，块按2的幂大小自然对齐，MEM_SIZE须为2的幂；mem_heap_xxx接口不受影响
+#endif
+
+#if MEM_BUDDY
+#ifndef MEM_BUDDY_MIN_LOG2
+#define MEM_BUDDY_MIN_LOG2 5 // 伙伴分配器最小块大小(log2)
+#endif
+#endif
+
+#ifndef MEM_SL_INDEX_COUNT_LOG2
+#define MEM_SL_INDEX_COUNT_LOG2 3 // 每个一级区间细分的二级链表数量(log2)
+#endif
+
+#ifndef MEM_FL_INDEX_MAX
+#define MEM_FL_INDEX_MAX 16 // 最大一级索引，单个堆可管理的空间小于 2^MEM_FL_INDEX_MAX
+#endif
+
+#ifndef MEM_ALIGN_SIZE_LOG2
+#define MEM_ALIGN_SIZE_LOG2 3 // 内存块对齐粒度(log2)，所有返回地址均按此对齐，不能小于指针大小
+#endif
+#define MEM_ALIGN_SIZE (1 << MEM_ALIGN_SIZE_LOG2)
+
+#if MEM_ALIGN_SIZE_LOG2 < 2 || (UINTPTR_MAX > 0xFFFFFFFFu && MEM_ALIGN_SIZE_LOG2 < 3)
+#error "MEM_ALIGN_SIZE must not be smaller than sizeof(void*)"
+#endif
+
+#ifndef MEM_ISR_SAFE
+#define MEM_ISR_SAFE 0 // 1:默认堆(mem_alloc等接口)可在中断中使用，需要C11 <stdatomic.h>
+#endif
+
+#if MEM_ISR_SAFE
+#ifndef MEM_MAG_BLOCK_SIZE
+#define MEM_MAG_BLOCK_SIZE 128 // 缓存块大小，中断中不大于此大小的申请从缓存获取
+#endif
+#ifndef MEM_MAG_DEPTH
+#define MEM_MAG_DEPTH 4 // 中断/线程缓存的块数量，必须为2的幂
+#endif
+#endif
+
+#ifndef MEM_QUICK_LIST
+#define MEM_QUICK_LIST 1 // 1:热点大小的内存块释放后暂不合并，留给下一次同尺寸申请直接使用
+#endif
+
+#if MEM_QUICK_LIST
+#ifndef MEM_QUICK_SIZES
+#define MEM_QUICK_SIZES 128, 133 // 热点申请大小(Byte)：打印缓冲区、Ymodem 128数据帧；堆放得下1K数据帧时可加入1029
+#endif
+#ifndef MEM_QUICK_NUM
+#define MEM_QUICK_NUM 2 // MEM_QUICK_SIZES中的个数
+#endif
+#ifndef MEM_QUICK_DEPTH
+#define MEM_QUICK_DEPTH 4 // 每个快速链表最多暂存的块数
+#endif
+#endif
+
+#ifndef MEM_QUOTA
+#define MEM_QUOTA 0 // 1:默认堆按标记(子系统)统计用量并限制配额，见mem_alloc_tag()
+#endif
+
+#if MEM_QUOTA
+#ifndef MEM_QUOTA_TAGS
+#define MEM_QUOTA_TAGS 8 // 标记数量
+#endif
+#endif
+
+#ifndef MEM_STATS
+#define MEM_STATS 1 // 1:统计堆的使用情况，见mem_stats()
+#endif
+
+#if MEM_STATS
+#ifndef MEM_STATS_HIST_BINS
+#define MEM_STATS_HIST_BINS 16 // 申请耗时直方图格数
+#endif
+#endif
+
+#ifndef MEM_TRACE
+#define MEM_TRACE 0 // 1:记录默认堆的申请/释放事件，通过mem_trace_dump()输出，用tools/mem_replay回放
+#endif
+
+#if MEM_TRACE
+#ifndef MEM_TRACE_DEPTH
+#define MEM_TRACE_DEPTH 256 // 事件缓冲区深度
+#endif
+#endif
+
+#define MEM_SL_INDEX_COUNT (1 << MEM_SL_INDEX_COUNT_LOG2)
+#define MEM_FL_INDEX_SHIFT (MEM_SL_INDEX_COUNT_LOG2 + MEM_ALIGN_SIZE_LOG2)
+#define MEM_FL_INDEX_COUNT (MEM_FL_INDEX_MAX - MEM_FL_INDEX_SHIFT + 1)
+
+//------------------------------ typedef --------------------------------//
+struct mem_block;
+
+#if MEM_STATS
+// 堆统计信息，计数器在申请/释放时增量维护，读取为O(1)
+typedef struct mem_stats {
+    size_t total_size; // 堆管理区大小
+    size_t used_size; // 已使用内存块的负载大小之和
+    size_t peak_used_size; // used_size的峰值
+    size_t free_size; // 空闲内存块的负载大小之和，含快速链表中暂存的块
+    size_t largest_free; // 最大空闲块(取最高非空空闲链表和快速链表的表头，误差小于该二级区间宽度)
+    uint32_t free_blocks; // 空闲内存块数量，含快速链表中暂存的块
+    uint32_t alloc_count; // 申请成功次数
+    uint32_t free_count; // 释放次数
+    uint32_t fail_count; // 申请失败次数
+    uint32_t frag_permille; // 碎片率(千分比) = 1 - largest_free / free_size
+    uint32_t alloc_hist[MEM_STATS_HIST_BINS]; // 申请耗时直方图，第i格为[2^i, 2^(i+1))个周期，见MEM_STATS_CYCLES
+} mem_stats_t;
+#endif
+
+#if MEM_TRACE
+#define MEM_TRACE_MAGIC 0x4352544Du // "MTRC"
+#define MEM_TRACE_VERSION 1
+#define MEM_TRACE_NULL 0xFFFFFFFFu // 偏移无效(NULL)
+
+typedef enum {
+    MEM_TRACE_ALLOC = 1,
+    MEM_TRACE_FREE,
+    MEM_TRACE_REALLOC,
+    MEM_TRACE_ALLOC_ALIGNED,
+} mem_trace_type_e;
+
+// 事件记录输出的文件头
+typedef struct mem_trace_header {
+    uint32_t magic; // MEM_TRACE_MAGIC
+    uint16_t version; // MEM_TRACE_VERSION
+    uint16_t event_size; // sizeof(mem_trace_event_t)
+    uint32_t heap_size; // 默认堆管理区大小
+    uint32_t count; // 事件数量
+    uint32_t dropped; // 缓冲区满后丢弃的事件数
+} mem_trace_header_t;
+
+// 申请/释放事件，20Byte
+typedef struct mem_trace_event {
+    uint32_t time; // 时间戳，见MEM_TRACE_TIME
+    uint32_t size; // 申请大小，free时为0
+    uint32_t offset; // 返回内存相对堆起始的偏移，MEM_TRACE_NULL表示返回NULL
+    uint32_t arg; // free/realloc为原内存偏移，对齐申请为对齐字节数
+    uint8_t type; // mem_trace_type_e
+    uint8_t tag; // 调用者标记，见mem_trace_set_tag
+    uint16_t reserved;
+} mem_trace_event_t;
+#endif
+
+#define MEM_QUOTA_TAG_DEFAULT 0 // mem_alloc等不带标记的接口使用的标记
+
+#if MEM_QUOTA
+// 标记的配额与用量，用量按内存块实际大小计
+typedef struct mem_quota {
+    size_t limit; // 配额，0表示不限制
+    size_t used; // 当前用量
+    size_t peak; // 用量峰值
+    uint32_t fail_count; // 超出配额导致的申请失败次数
+} mem_quota_t;
+#endif
+
+// 堆控制结构，每个堆管理一块独立的内存区域(如CCM RAM、DMA可访问的SRAM等)
+typedef struct mem_heap {
+    uint32_t fl_bitmap; // 一级位图，bit置位表示该一级区间内存在空闲块
+    uint32_t sl_bitmap[MEM_FL_INDEX_COUNT]; // 二级位图
+    struct mem_block *blocks[MEM_FL_INDEX_COUNT][MEM_SL_INDEX_COUNT]; // 空闲链表头
+    char *start; // 管理区域起始地址
+    char *end; // 管理区域结束地址
+#if MEM_QUICK_LIST
+    struct mem_block *quick[MEM_QUICK_NUM]; // 快速链表，块保持已使用状态，不与相邻块合并
+    uint8_t quick_count[MEM_QUICK_NUM]; // 快速链表中的块数
+#endif
+#if MEM_STATS
+    mem_stats_t stats; // 统计信息
+#endif
+} mem_heap_t;
+
+int mem_heap_init(mem_heap_t *heap, void *buf, size_t len);
+void *mem_heap_alloc(mem_heap_t *heap, size_t size);
+void *mem_heap_alloc_aligned(mem_heap_t *heap, size_t size, size_t align);
+void mem_heap_free(mem_heap_t *heap, void *ptr);
+void *mem_heap_realloc(mem_heap_t *heap, void *ptr, size_t size);
+#if MEM_STATS
+void mem_heap_stats(mem_heap_t *heap, mem_stats_t *stats);
+#endif
 
 void mem_init(void);
 void *mem_alloc(size_t size);
+void *mem_alloc_aligned(size_t size, size_t align);
 void mem_free(void *ptr);
 void *mem_realloc(void *ptr, size_t size);
+#if MEM_QUOTA
+void *mem_alloc_tag(uint8_t tag, size_t size);
+void *mem_alloc_aligned_tag(uint8_t tag, size_t size, size_t align);
+void mem_quota_set(uint8_t tag, size_t limit);
+void mem_quota_get(uint8_t tag, mem_quota_t *quota);
+#endif
+#if MEM_ISR_SAFE
+void mem_service(void);
+#endif
+#if MEM_STATS
+void mem_stats(mem_stats_t *stats);
+#endif
+#if MEM_TRACE
+void mem_trace_start(void);
+void mem_trace_stop(void);
+void mem_trace_set_tag(uint8_t tag);
+void mem_trace_dump(void (*write)(const uint8_t *buf, size_t len));
+#endif
+
+#ifdef __cplusplus
+}
+#endif
 
-#endif /* __MEM_MALLOC_H__ */
\ No newline at end of file
+#endif /* __MEM_MALLOC_H__ */
@@ -0,0 +1,95 @@
+/**
+ * @file mem_pool.c
+ * @author h
+ * @brief 固定大小对象内存池
+ * @version 0.1
+ * @date 2026-10-17
+ * @attention 空闲对象的前sizeof(void*)字节用作链表指针，对象本身没有额外的头部，
+ *            申请/释放均为一次链表头的弹出/压入
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "mem_pool.h"
+
+typedef char mem_pool_align_check[(MEM_POOL_ALIGN_SIZE & (MEM_POOL_ALIGN_SIZE - 1)) == 0
+                                  && MEM_POOL_ALIGN_SIZE >= sizeof(void*) ? 1 : -1];
+
+/**
+ * @brief 在storage上创建一个固定大小对象内存池
+ *
+ * @param obj_size 对象大小，以Byte为单位
+ * @param count 对象数量
+ * @param storage 内存池空间，大小至少为MEM_POOL_STORAGE_SIZE(obj_size, count)，按MEM_POOL_ALIGN_SIZE对齐
+ * @return mem_pool_t* 内存池句柄，NULL表示参数错误
+ */
+mem_pool_t *mem_pool_create(size_t obj_size, size_t count, void *storage)
+{
+    mem_pool_t *pool = (mem_pool_t*)storage;
+    char *obj;
+    size_t i;
+
+    if (!storage || !count || ((size_t)storage & (MEM_POOL_ALIGN_SIZE - 1))) {
+        return NULL;
+    }
+    pool->obj_size = MEM_POOL_OBJ_SIZE(obj_size);
+    pool->count = count;
+    pool->free_count = count;
+    pool->start = (char*)storage + MEM_POOL_ALIGN(sizeof(mem_pool_t));
+    pool->end = pool->start + pool->obj_size * count;
+
+    // 将所有对象串成空闲链表
+    obj = pool->start;
+    for (i = 0; i < count - 1; i++) {
+        *(void**)obj = obj + pool->obj_size;
+        obj += pool->obj_size;
+    }
+    *(void**)obj = NULL;
+    pool->free_list = pool->start;
+
+    return pool;
+}
+
+/**
+ * @brief 从内存池中取一个对象
+ *
+ * @param pool 内存池句柄
+ * @return void* 对象地址，NULL表示内存池已空
+ */
+void *mem_pool_get(mem_pool_t *pool)
+{
+    void *obj = pool->free_list;
+    if (obj) {
+        pool->free_list = *(void**)obj;
+        pool->free_count--;
+    }
+    return obj;
+}
+
+/**
+ * @brief 将对象归还内存池
+ *
+ * @param pool 内存池句柄
+ * @param obj 由mem_pool_get获取的对象地址
+ */
+void mem_pool_put(mem_pool_t *pool, void *obj)
+{
+    if (!obj || (char*)obj < pool->start || (char*)obj >= pool->end) {
+        return;
+    }
+    *(void**)obj = pool->free_list;
+    pool->free_list = obj;
+    pool->free_count++;
+}
+
+/**
+ * @brief 查询内存池中剩余空闲对象数量
+ *
+ * @param pool 内存池句柄
+ * @return size_t 空闲对象数量
+ */
+size_t mem_pool_free_count(const mem_pool_t *pool)
+{
+    return pool->free_count;
+}
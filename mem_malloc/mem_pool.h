@@ -0,0 +1,64 @@
+/**
+ * @file mem_pool.h
+ * @author h
+ * @brief 固定大小对象内存池
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __MEM_POOL_H__
+#define __MEM_POOL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 对象的对齐粒度，必须为2的幂且不小于指针大小，默认为max_align_t的对齐(Cortex-M为8)
+#ifndef MEM_POOL_ALIGN_SIZE
+#if defined(__cplusplus)
+#define MEM_POOL_ALIGN_SIZE alignof(max_align_t)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define MEM_POOL_ALIGN_SIZE _Alignof(max_align_t)
+#else
+#define MEM_POOL_ALIGN_SIZE 8 // C11之前没有max_align_t，与C++代码混用时需两边一致
+#endif
+#endif
+
+// 内存池控制结构，存放在storage的起始处
+typedef struct mem_pool {
+    void *free_list; // 空闲对象链表，链表指针嵌入在空闲对象中
+    size_t obj_size; // 对象大小(已对齐)
+    size_t count; // 对象总数
+    size_t free_count; // 空闲对象数
+    char *start; // 对象区起始地址
+    char *end; // 对象区结束地址
+} mem_pool_t;
+
+#define MEM_POOL_ALIGN(x) (((x) + MEM_POOL_ALIGN_SIZE - 1) & ~((size_t)MEM_POOL_ALIGN_SIZE - 1))
+#define MEM_POOL_OBJ_SIZE(obj_size) \
+        MEM_POOL_ALIGN((obj_size) < sizeof(void*) ? sizeof(void*) : (obj_size))
+// 容纳count个obj_size大小对象所需的storage大小(Byte)
+#define MEM_POOL_STORAGE_SIZE(obj_size, count) \
+        (MEM_POOL_ALIGN(sizeof(mem_pool_t)) + MEM_POOL_OBJ_SIZE(obj_size) * (count))
+// 定义一块按MEM_POOL_ALIGN_SIZE对齐的storage
+#define MEM_POOL_STORAGE(name, obj_size, count) \
+        static void *name[(MEM_POOL_STORAGE_SIZE(obj_size, count) + sizeof(void*) - 1) / sizeof(void*)] \
+        __attribute__((aligned(MEM_POOL_ALIGN_SIZE)))
+
+mem_pool_t *mem_pool_create(size_t obj_size, size_t count, void *storage);
+void *mem_pool_get(mem_pool_t *pool);
+void mem_pool_put(mem_pool_t *pool, void *obj);
+size_t mem_pool_free_count(const mem_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_POOL_H__ */
@@ -0,0 +1,219 @@
+/**
+ * @file mem_resource.hpp
+ * @author h
+ * @brief std::pmr::memory_resource适配，让pmr容器从mem_malloc的堆、线性分配器、内存池申请内存
+ * @version 0.1
+ * @date 2026-10-17
+ * @attention 需要C++17 <memory_resource>。用法:
+ *              std::pmr::vector<uint8_t> buf(mem::default_heap());
+ *            或std::pmr::set_default_resource(mem::default_heap())使所有未指定资源的pmr容器使用默认堆。
+ *            申请失败时抛出std::bad_alloc，未开启异常(-fno-exceptions)时调用std::abort。
+ *            不依赖RTTI，资源只与自身相等，共用同一个堆的容器应使用同一个资源对象(如mem::default_heap())
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef __MEM_RESOURCE_HPP__
+#define __MEM_RESOURCE_HPP__
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <memory_resource>
+#include "mem_malloc.h"
+#include "mem_arena.h"
+#include "mem_pool.h"
+
+namespace mem {
+
+namespace detail {
+
+[[noreturn]] inline void throw_bad_alloc()
+{
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif
+}
+
+inline void *check(void *ptr)
+{
+    if (!ptr) {
+        throw_bad_alloc();
+    }
+    return ptr;
+}
+
+} // namespace detail
+
+/**
+ * @brief 默认堆(mem_alloc/mem_free)
+ *
+ */
+class default_heap_resource : public std::pmr::memory_resource {
+public:
+    default_heap_resource() = default;
+#if MEM_QUOTA
+    /**
+     * @param tag 申请计入的配额标记，见mem_alloc_tag
+     */
+    explicit default_heap_resource(uint8_t tag) : tag_(tag) {}
+#endif
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+#if MEM_QUOTA
+        if (alignment > MEM_ALIGN_SIZE) {
+            return detail::check(mem_alloc_aligned_tag(tag_, bytes, alignment));
+        }
+        return detail::check(mem_alloc_tag(tag_, bytes));
+#else
+        if (alignment > MEM_ALIGN_SIZE) {
+            return detail::check(mem_alloc_aligned(bytes, alignment));
+        }
+        return detail::check(mem_alloc(bytes));
+#endif
+    }
+
+    void do_deallocate(void *p, std::size_t, std::size_t) override
+    {
+        mem_free(p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+#if MEM_QUOTA
+    uint8_t tag_ = MEM_QUOTA_TAG_DEFAULT;
+#endif
+};
+
+/**
+ * @brief 独立的堆(mem_heap_t)，如CCM RAM、DMA可访问的SRAM
+ *
+ */
+class heap_resource : public std::pmr::memory_resource {
+public:
+    /**
+     * @param heap 已由mem_heap_init初始化的堆
+     */
+    explicit heap_resource(mem_heap_t *heap) : heap_(heap) {}
+
+    mem_heap_t *heap() const { return heap_; }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (alignment > MEM_ALIGN_SIZE) {
+            return detail::check(mem_heap_alloc_aligned(heap_, bytes, alignment));
+        }
+        return detail::check(mem_heap_alloc(heap_, bytes));
+    }
+
+    void do_deallocate(void *p, std::size_t, std::size_t) override
+    {
+        mem_heap_free(heap_, p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    mem_heap_t *heap_;
+};
+
+/**
+ * @brief 线性分配器(arena_t)，释放为空操作，通过mark/release或reset整体回收
+ * @attention 与std::pmr::monotonic_buffer_resource类似，
+ *            但空间用完时不向上游申请，直接失败
+ *
+ */
+class arena_resource : public std::pmr::memory_resource {
+public:
+    /**
+     * @param arena 已由arena_init初始化的线性分配器
+     */
+    explicit arena_resource(arena_t *arena) : arena_(arena) {}
+
+    arena_t *arena() const { return arena_; }
+    arena_mark_t mark() const { return arena_mark(arena_); }
+    void release(arena_mark_t mark) { arena_release(arena_, mark); }
+    void reset() { arena_reset(arena_); }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (alignment > MEM_ARENA_ALIGN) {
+            return detail::check(arena_alloc_aligned(arena_, bytes, alignment));
+        }
+        return detail::check(arena_alloc(arena_, bytes));
+    }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    arena_t *arena_;
+};
+
+/**
+ * @brief 固定大小对象内存池(mem_pool_t)，适合std::pmr::list/map等节点容器
+ * @attention 申请大小超过对象大小或对齐要求超过MEM_POOL_ALIGN_SIZE时失败
+ *
+ */
+class pool_resource : public std::pmr::memory_resource {
+public:
+    /**
+     * @param pool 已由mem_pool_create创建的内存池
+     */
+    explicit pool_resource(mem_pool_t *pool) : pool_(pool) {}
+
+    mem_pool_t *pool() const { return pool_; }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (bytes > pool_->obj_size || alignment > MEM_POOL_ALIGN_SIZE) {
+            detail::throw_bad_alloc();
+        }
+        return detail::check(mem_pool_get(pool_));
+    }
+
+    void do_deallocate(void *p, std::size_t, std::size_t) override
+    {
+        mem_pool_put(pool_, p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    mem_pool_t *pool_;
+};
+
+/**
+ * @brief 默认堆资源的共用实例
+ *
+ * @return default_heap_resource* 资源
+ */
+inline default_heap_resource *default_heap()
+{
+    static default_heap_resource res;
+    return &res;
+}
+
+} // namespace mem
+
+#endif /* __MEM_RESOURCE_HPP__ */
@@ -0,0 +1,158 @@
+/**
+ * @file mem_quota_test.c
+ * @author h
+ * @brief 主机端配额模式下mem_realloc的检查程序
+ * @version 0.1
+ * @date 2026-10-17
+ * @attention 编译(Linux):
+ *            gcc -O2 -I.. -DMEM_QUOTA=1 mem_quota_test.c ../mem_malloc.c -o mem_quota_test
+ *            加-DMEM_BUDDY=1或-DMEM_ISR_SAFE=1编译可检查对应模式，全部通过时输出ok并返回0
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mem_malloc.h"
+
+#if !MEM_QUOTA
+#error "build with -DMEM_QUOTA=1"
+#endif
+
+#define TEST_SLOTS 16
+#define TEST_ROUNDS 100000
+
+#define TEST_CHECK(cond)                                                    \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                        \
+        }                                                                   \
+    } while (0)
+
+static size_t quota_used(uint8_t tag)
+{
+    mem_quota_t quota;
+
+    mem_quota_get(tag, &quota);
+    return quota.used;
+}
+
+static void fill(unsigned char *p, size_t from, size_t to, int seed)
+{
+    size_t i;
+
+    for (i = from; i < to; i++) {
+        p[i] = (unsigned char)(seed + i);
+    }
+}
+
+static int intact(const unsigned char *p, size_t len, int seed)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (p[i] != (unsigned char)(seed + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief 扩大后的内存块取整后超出配额：返回NULL，原内存、数据和用量不变
+ *
+ */
+static void test_realloc_over_quota(void)
+{
+    unsigned char *p, *q;
+    size_t used;
+
+    p = mem_alloc_tag(1, 24);
+    TEST_CHECK(p);
+    fill(p, 0, 24, 1);
+    // 配额只比当前内存块多1字节，扩大1字节后内存块至少多一个对齐单位
+    used = quota_used(1);
+    mem_quota_set(1, used + 1);
+
+    TEST_CHECK(mem_realloc(p, used + 1) == NULL);
+    TEST_CHECK(quota_used(1) == used);
+    TEST_CHECK(intact(p, 24, 1));
+    // 原内存仍被占用，不会被再次分配出去
+    q = mem_alloc(24);
+    TEST_CHECK(q != p);
+    mem_free(q);
+
+    mem_free(p);
+    TEST_CHECK(quota_used(1) == 0);
+    mem_quota_set(1, 0);
+}
+
+/**
+ * @brief 随机申请/调整/释放：失败的realloc不改变原内存，用量不超过配额，全部释放后归零
+ *
+ */
+static void test_realloc_random(void)
+{
+    static const size_t limit[4] = {0, 300, 500, 700};
+    unsigned char *slot[TEST_SLOTS] = {0};
+    size_t len[TEST_SLOTS];
+    unsigned char *p;
+    mem_quota_t quota;
+    size_t size, used;
+    int i, k, t;
+
+    for (t = 1; t < 4; t++) {
+        mem_quota_set((uint8_t)t, limit[t]);
+    }
+    srand(7);
+    for (i = 0; i < TEST_ROUNDS; i++) {
+        k = rand() % TEST_SLOTS;
+        t = k % 4;
+        size = (size_t)(rand() % 250 + 1);
+        if (!slot[k]) {
+            slot[k] = mem_alloc_tag((uint8_t)t, size);
+            if (slot[k]) {
+                len[k] = size;
+                fill(slot[k], 0, size, k);
+            }
+        } else if (rand() % 3 == 0) {
+            TEST_CHECK(intact(slot[k], len[k], k));
+            mem_free(slot[k]);
+            slot[k] = NULL;
+        } else {
+            used = quota_used((uint8_t)t);
+            p = mem_realloc(slot[k], size);
+            if (!p) {
+                TEST_CHECK(quota_used((uint8_t)t) == used);
+                TEST_CHECK(intact(slot[k], len[k], k));
+            } else {
+                TEST_CHECK(intact(p, size < len[k] ? size : len[k], k));
+                fill(p, len[k], size, k);
+                slot[k] = p;
+                len[k] = size;
+            }
+        }
+        for (t = 1; t < 4; t++) {
+            mem_quota_get((uint8_t)t, &quota);
+            TEST_CHECK(quota.used <= limit[t] && quota.peak <= limit[t]);
+        }
+    }
+    for (k = 0; k < TEST_SLOTS; k++) {
+        mem_free(slot[k]);
+    }
+    for (t = 0; t < 4; t++) {
+        TEST_CHECK(quota_used((uint8_t)t) == 0);
+        mem_quota_set((uint8_t)t, 0);
+    }
+}
+
+int main(void)
+{
+    mem_init();
+    test_realloc_over_quota();
+    test_realloc_random();
+    puts("ok");
+    return 0;
+}
@@ -0,0 +1,515 @@
+/**
+ * @file mem_replay.c
+ * @author h
+ * @brief 主机端内存事件回放工具，对比不同分配器在真实申请序列下的表现
+ * @version 0.1
+ * @date 2026-10-17
+ * @attention 编译(Linux):
+ *            gcc -O2 -I.. -DMEM_TRACE=1 mem_replay.c ../mem_malloc.c -o mem_replay
+ *            使用:
+ *            ./mem_replay trace.bin [heap_size]
+ *            trace.bin为目标板mem_trace_dump()输出的原始数据，
+ *            heap_size缺省使用记录中的堆大小(默认堆固定为MEM_SIZE)
+ *            加-DMEM_BUDDY=1 -DMEM_SIZE=<2的幂>编译可对比伙伴分配模式
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include "mem_malloc.h"
+
+#if !MEM_TRACE
+#error "build with -DMEM_TRACE=1"
+#endif
+
+//------------------------------ typedef --------------------------------//
+// 被测分配器
+typedef struct replay_allocator {
+    const char *name;
+    int (*init)(size_t heap_size);
+    void *(*alloc)(size_t size);
+    void *(*alloc_aligned)(size_t size, size_t align);
+    void (*free)(void *ptr);
+    void *(*realloc)(void *ptr, size_t size);
+    size_t (*footprint)(void); // 当前占用的字节数(已使用块的大小，含块头等管理开销)，回放中取其峰值
+    void (*deinit)(void);
+} replay_allocator_t;
+
+// 每类操作的耗时统计
+typedef struct replay_time {
+    uint32_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} replay_time_t;
+
+//------------------------------ tlsf --------------------------------//
+static mem_heap_t tlsf_heap;
+static char *tlsf_buf = NULL;
+static int tlsf_init(size_t heap_size)
+{
+    tlsf_buf = aligned_alloc(64, (heap_size + 63) & ~(size_t)63);
+    return tlsf_buf ? mem_heap_init(&tlsf_heap, tlsf_buf, heap_size) : -1;
+}
+
+static void *tlsf_alloc(size_t size)
+{
+    return mem_heap_alloc(&tlsf_heap, size);
+}
+
+static void *tlsf_alloc_aligned(size_t size, size_t align)
+{
+    return mem_heap_alloc_aligned(&tlsf_heap, size, align);
+}
+
+static void tlsf_free(void *ptr)
+{
+    mem_heap_free(&tlsf_heap, ptr);
+}
+
+static void *tlsf_realloc(void *ptr, size_t size)
+{
+    return mem_heap_realloc(&tlsf_heap, ptr, size);
+}
+
+static size_t tlsf_footprint(void)
+{
+#if MEM_STATS
+    mem_stats_t stats;
+    mem_heap_stats(&tlsf_heap, &stats);
+    return stats.total_size - stats.free_size;
+#else
+    return 0;
+#endif
+}
+
+static void tlsf_deinit(void)
+{
+    free(tlsf_buf);
+    tlsf_buf = NULL;
+}
+
+//------------------------------ default heap --------------------------------//
+/*
+ * 默认堆(mem_alloc等接口)，大小固定为MEM_SIZE，
+ * 按目标板的配置编译即可回放该配置，如-DMEM_BUDDY=1 -DMEM_SIZE=4096
+ */
+static int default_init(size_t heap_size)
+{
+    (void)heap_size;
+    mem_init();
+    mem_trace_stop();
+    return 0;
+}
+
+static size_t default_footprint(void)
+{
+#if MEM_STATS
+    mem_stats_t stats;
+    mem_stats(&stats);
+    return stats.total_size - stats.free_size;
+#else
+    return 0;
+#endif
+}
+
+static void default_deinit(void)
+{
+}
+
+//------------------------------ first fit --------------------------------//
+/*
+ * 原mem_malloc.c的首次适配算法：按地址顺序遍历内存块链表，
+ * 作为对比基准保留在此(修正了合并时prev指针未更新的问题)
+ */
+typedef struct ff_block {
+    size_t size;
+    int used;
+    struct ff_block *next;
+    struct ff_block *prev;
+} FfBlock;
+
+static char *ff_buf = NULL;
+static size_t ff_size = 0;
+
+static int ff_init(size_t heap_size)
+{
+    FfBlock *block;
+    ff_buf = malloc(heap_size);
+    if (!ff_buf) {
+        return -1;
+    }
+    ff_size = heap_size;
+    block = (FfBlock*)ff_buf;
+    block->size = heap_size - sizeof(FfBlock);
+    block->next = block->prev = NULL;
+    block->used = 0;
+    return 0;
+}
+
+static void *ff_alloc(size_t size)
+{
+    FfBlock *curr_block = (FfBlock*)ff_buf;
+
+    size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    while (curr_block) {
+        if (!curr_block->used && curr_block->size >= size) {
+            if (curr_block->size - size >= sizeof(FfBlock)) {
+                FfBlock *new_block = (FfBlock*)((char*)curr_block + sizeof(FfBlock) + size);
+                new_block->size = curr_block->size - sizeof(FfBlock) - size;
+                new_block->next = curr_block->next;
+                new_block->prev = curr_block;
+                new_block->used = 0;
+                if (new_block->next) {
+                    new_block->next->prev = new_block;
+                }
+                curr_block->size = size;
+                curr_block->next = new_block;
+            }
+            curr_block->used = 1;
+            return (char*)curr_block + sizeof(FfBlock);
+        }
+        curr_block = curr_block->next;
+    }
+    return NULL;
+}
+
+static void *ff_alloc_aligned(size_t size, size_t align)
+{
+    // 首次适配没有对齐申请，只能多申请后对齐，无法释放，回放时按普通申请处理
+    (void)align;
+    return ff_alloc(size);
+}
+
+static void ff_free(void *ptr)
+{
+    FfBlock *curr_block, *next_block, *prev_block;
+
+    if (!ptr) {
+        return;
+    }
+    curr_block = (FfBlock*)((char*)ptr - sizeof(FfBlock));
+    curr_block->used = 0;
+    next_block = curr_block->next;
+    if (next_block && !next_block->used) {
+        curr_block->size += sizeof(FfBlock) + next_block->size;
+        curr_block->next = next_block->next;
+        if (curr_block->next) {
+            curr_block->next->prev = curr_block;
+        }
+    }
+    prev_block = curr_block->prev;
+    if (prev_block && !prev_block->used) {
+        prev_block->size += sizeof(FfBlock) + curr_block->size;
+        prev_block->next = curr_block->next;
+        if (prev_block->next) {
+            prev_block->next->prev = prev_block;
+        }
+    }
+}
+
+static void *ff_realloc(void *ptr, size_t size)
+{
+    FfBlock *curr_block;
+    void *new_ptr;
+
+    if (!ptr) {
+        return ff_alloc(size);
+    }
+    curr_block = (FfBlock*)((char*)ptr - sizeof(FfBlock));
+    if (size <= curr_block->size) {
+        return ptr;
+    }
+    new_ptr = ff_alloc(size);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, curr_block->size);
+        ff_free(ptr);
+    }
+    return new_ptr;
+}
+
+static size_t ff_footprint(void)
+{
+    size_t used = 0;
+    FfBlock *block = (FfBlock*)ff_buf;
+    while (block) {
+        if (!block->used) {
+            used += block->size;
+        }
+        block = block->next;
+    }
+    return ff_size - used;
+}
+
+static void ff_deinit(void)
+{
+    free(ff_buf);
+    ff_buf = NULL;
+}
+
+//------------------------------ glibc --------------------------------//
+static size_t libc_used = 0;
+
+static int libc_init(size_t heap_size)
+{
+    (void)heap_size;
+    libc_used = 0;
+    return 0;
+}
+
+static void *libc_alloc(size_t size)
+{
+    void *ptr = malloc(size);
+    libc_used += ptr ? malloc_usable_size(ptr) : 0;
+    return ptr;
+}
+
+static void *libc_alloc_aligned(size_t size, size_t align)
+{
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, align < sizeof(void*) ? sizeof(void*) : align, size)) {
+        return NULL;
+    }
+    libc_used += malloc_usable_size(ptr);
+    return ptr;
+}
+
+static void libc_free(void *ptr)
+{
+    libc_used -= ptr ? malloc_usable_size(ptr) : 0;
+    free(ptr);
+}
+
+static void *libc_realloc(void *ptr, size_t size)
+{
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void *new_ptr = realloc(ptr, size);
+    if (new_ptr) {
+        libc_used = libc_used - old + malloc_usable_size(new_ptr);
+    }
+    return new_ptr;
+}
+
+static size_t libc_footprint(void)
+{
+    return libc_used;
+}
+
+static void libc_deinit(void)
+{
+}
+
+static const replay_allocator_t replay_allocators[] = {
+    {"tlsf", tlsf_init, tlsf_alloc, tlsf_alloc_aligned, tlsf_free, tlsf_realloc, tlsf_footprint, tlsf_deinit},
+    {"first-fit", ff_init, ff_alloc, ff_alloc_aligned, ff_free, ff_realloc, ff_footprint, ff_deinit},
+#if MEM_BUDDY
+    {"buddy", default_init, mem_alloc, mem_alloc_aligned, mem_free, mem_realloc, default_footprint, default_deinit},
+#else
+    {"default", default_init, mem_alloc, mem_alloc_aligned, mem_free, mem_realloc, default_footprint, default_deinit},
+#endif
+    {"glibc", libc_init, libc_alloc, libc_alloc_aligned, libc_free, libc_realloc, libc_footprint, libc_deinit},
+};
+
+//------------------------------ replay --------------------------------//
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void time_add(replay_time_t *t, uint64_t ns)
+{
+    t->count++;
+    t->total_ns += ns;
+    if (ns > t->max_ns) {
+        t->max_ns = ns;
+    }
+}
+
+/**
+ * @brief 记录中的偏移是否在跟踪表范围内
+ *
+ * @param offset 偏移，MEM_TRACE_NULL表示NULL
+ * @param trace_size 记录时的堆大小
+ * @return int 1:在范围内
+ */
+static int replay_tracked(uint32_t offset, size_t trace_size)
+{
+    return offset != MEM_TRACE_NULL && offset / 4 <= trace_size / 4;
+}
+
+/**
+ * @brief 用一个分配器回放事件序列
+ *
+ * @param a 分配器
+ * @param events 事件
+ * @param count 事件数量
+ * @param trace_size 记录时的堆大小
+ * @param heap_size 回放时的堆大小
+ */
+static void replay(const replay_allocator_t *a, const mem_trace_event_t *events, uint32_t count,
+                   size_t trace_size, size_t heap_size)
+{
+    // 记录中的偏移 -> 回放时的指针，偏移按4Byte对齐
+    void **live = calloc(trace_size / 4 + 1, sizeof(void*));
+    replay_time_t times[MEM_TRACE_ALLOC_ALIGNED + 1] = {0};
+    size_t peak = 0, footprint;
+    uint32_t fails = 0, first_fail = 0, i;
+    const mem_trace_event_t *e;
+    void *ptr, *old;
+    uint64_t t0, t1;
+
+    if (!live || a->init(heap_size)) {
+        printf("%-10s init failed\n", a->name);
+        free(live);
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        e = &events[i];
+        old = replay_tracked(e->arg, trace_size) ? live[e->arg / 4] : NULL;
+        ptr = NULL;
+        t0 = now_ns();
+        switch (e->type) {
+            case MEM_TRACE_ALLOC:
+                ptr = a->alloc(e->size);
+                break;
+            case MEM_TRACE_ALLOC_ALIGNED:
+                ptr = a->alloc_aligned(e->size, e->arg);
+                old = NULL;
+                break;
+            case MEM_TRACE_FREE:
+                a->free(old);
+                break;
+            case MEM_TRACE_REALLOC:
+                ptr = a->realloc(old, e->size);
+                break;
+            default:
+                continue;
+        }
+        t1 = now_ns();
+        if (e->type <= MEM_TRACE_ALLOC_ALIGNED) {
+            time_add(&times[e->type], t1 - t0);
+        }
+
+        if (e->type == MEM_TRACE_FREE) {
+            if (replay_tracked(e->arg, trace_size)) {
+                live[e->arg / 4] = NULL;
+            }
+            continue;
+        }
+        if (e->type == MEM_TRACE_REALLOC) {
+            if (ptr) {
+                // 回放成功，原内存块已被移动或原地调整
+                if (replay_tracked(e->arg, trace_size)) {
+                    live[e->arg / 4] = NULL;
+                }
+                if (replay_tracked(e->offset, trace_size)) {
+                    live[e->offset / 4] = ptr;
+                } else if (replay_tracked(e->arg, trace_size)) {
+                    // 目标板上失败，原内存块仍在原偏移处，继续按原偏移跟踪
+                    live[e->arg / 4] = ptr;
+                } else {
+                    // 目标板上realloc(NULL, size)失败，不再跟踪
+                    a->free(ptr);
+                }
+            } else if (replay_tracked(e->offset, trace_size)) {
+                // 目标板上成功，回放失败：记录中原内存块已移到新偏移，
+                // 释放回放中的原内存块，使跟踪表与记录一致
+                a->free(old);
+                if (replay_tracked(e->arg, trace_size)) {
+                    live[e->arg / 4] = NULL;
+                }
+                live[e->offset / 4] = NULL;
+                if (!fails) {
+                    first_fail = i;
+                }
+                fails++;
+            }
+        } else if (replay_tracked(e->offset, trace_size)) {
+            live[e->offset / 4] = ptr;
+            if (!ptr) {
+                // 目标板上成功，回放失败
+                if (!fails) {
+                    first_fail = i;
+                }
+                fails++;
+            }
+        } else if (ptr) {
+            // 目标板上失败，回放成功，不再跟踪
+            a->free(ptr);
+        }
+        footprint = a->footprint();
+        if (footprint > peak) {
+            peak = footprint;
+        }
+    }
+
+    printf("%-10s peak %8zu  fail %6u", a->name, peak, fails);
+    if (fails) {
+        printf(" (first at event %u)", first_fail);
+    }
+    printf("\n");
+    printf("           %-14s %8s %10s %10s\n", "op", "count", "avg(ns)", "max(ns)");
+    for (i = MEM_TRACE_ALLOC; i <= MEM_TRACE_ALLOC_ALIGNED; i++) {
+        static const char *names[] = {"", "alloc", "free", "realloc", "alloc_aligned"};
+        if (times[i].count) {
+            printf("           %-14s %8u %10llu %10llu\n", names[i], times[i].count,
+                   (unsigned long long)(times[i].total_ns / times[i].count),
+                   (unsigned long long)times[i].max_ns);
+        }
+    }
+    // 释放回放结束时仍存活的内存
+    for (i = 0; i <= trace_size / 4; i++) {
+        a->free(live[i]);
+    }
+    a->deinit();
+    free(live);
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    mem_trace_header_t header;
+    mem_trace_event_t *events;
+    size_t heap_size;
+    uint32_t i;
+
+    if (argc < 2) {
+        printf("usage: %s trace.bin [heap_size]\n", argv[0]);
+        return 1;
+    }
+    fp = fopen(argv[1], "rb");
+    if (!fp) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != MEM_TRACE_MAGIC
+        || header.event_size != sizeof(mem_trace_event_t)) {
+        printf("%s: not a mem trace (version %u expected)\n", argv[1], MEM_TRACE_VERSION);
+        fclose(fp);
+        return 1;
+    }
+    events = malloc((size_t)header.count * sizeof(mem_trace_event_t) + 1);
+    if (!events || fread(events, sizeof(mem_trace_event_t), header.count, fp) != header.count) {
+        printf("%s: truncated\n", argv[1]);
+        fclose(fp);
+        free(events);
+        return 1;
+    }
+    fclose(fp);
+
+    heap_size = argc > 2 ? strtoul(argv[2], NULL, 0) : header.heap_size;
+    printf("trace: %u events, %u dropped, heap %u, replay heap %zu\n",
+           header.count, header.dropped, header.heap_size, heap_size);
+    for (i = 0; i < sizeof(replay_allocators) / sizeof(replay_allocators[0]); i++) {
+        replay(&replay_allocators[i], events, header.count, header.heap_size, heap_size);
+    }
+    free(events);
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include "bcast_ring.h"
+#include <string.h>
+
+/*
+ * 写端先发布claim(写入结束位置)，再写数据，最后发布tail；
+ * 读端拷贝[pos, pos + n)后重新读取claim，claim - pos > size说明拷贝期间这段数据已被覆盖，
+ * 丢弃本次拷贝并返回0，下次从claim - size(此刻仍完整的最早数据)读取
+ */
+#ifdef RINGBUF_SPSC
+#define bcast_fence_acquire()   atomic_thread_fence(memory_order_acquire)
+#define bcast_fence_release()   atomic_thread_fence(memory_order_release)
+#else
+#define bcast_fence_acquire()   __asm volatile("" ::: "memory")
+#define bcast_fence_release()   __asm volatile("" ::: "memory")
+#endif
+
+/**
+ * @brief 初始化广播ringbuf
+ *
+ * @param br: 广播ringbuf指针
+ * @param buf: 存储区
+ * @param size: 存储区长度，必须为2的幂
+ * @return uint8_t 1:成功 0:参数错误
+ */
+uint8_t bcast_ring_init(bcast_ring_t *br, void *buf, size_t size)
+{
+    if(br == NULL || buf == NULL)
+        return 0;
+    if(size == 0 || (size & (size - 1)) || size > 0x80000000u)
+        return 0;
+    br->buf = buf;
+    br->size = size;
+    br->mask = (uint32_t)(size - 1);
+    rb_store_release(br->claim, 0);
+    rb_store_release(br->tail, 0);
+    return 1;
+}
+
+/**
+ * @brief 写入数据，不等待读端，总是成功
+ * @attention 只能由一个写端调用(如串口中断)；
+ *            len超过缓冲区长度时只保留最后size字节，读端计为丢失
+ *
+ * @param br: 广播ringbuf指针
+ * @param data: 数据
+ * @param len: 数据长度
+ */
+void bcast_ring_write(bcast_ring_t *br, const uint8_t *data, size_t len)
+{
+    uint32_t tail, end, idx;
+    size_t n, sequential_bytes;
+
+    tail = rb_load_relaxed(br->tail);
+    end = tail + (uint32_t)len;
+    n = len;
+    if(n > br->size)
+    {
+        data += n - br->size;
+        n = br->size;
+    }
+
+    // 先发布将被覆盖的范围，再改写数据
+    rb_store_release(br->claim, end);
+    bcast_fence_release();
+
+    idx = (end - (uint32_t)n) & br->mask;
+    sequential_bytes = br->size - idx;
+    if(sequential_bytes >= n)
+    {
+        memcpy(br->buf + idx, data, n);
+    }
+    else
+    {
+        memcpy(br->buf + idx, data, sequential_bytes);
+        memcpy(br->buf, data + sequential_bytes, n - sequential_bytes);
+    }
+    rb_store_release(br->tail, end);
+}
+
+/**
+ * @brief 注册读端，从当前写位置开始读取，之前写入的数据不可见
+ *
+ * @param br: 广播ringbuf指针
+ * @param rd: 读端
+ */
+void bcast_reader_attach(bcast_ring_t *br, bcast_reader_t *rd)
+{
+    rd->ring = br;
+    rd->pos = rb_load_acquire(br->tail);
+    rd->lost = 0;
+}
+
+/**
+ * @brief 读端可读的字节数，读端跟不上时不超过缓冲区长度
+ *
+ * @param rd: 读端
+ * @return size_t 可读字节数
+ */
+size_t bcast_reader_available(const bcast_reader_t *rd)
+{
+    int32_t avail = (int32_t)(rb_load_acquire(rd->ring->tail) - rd->pos);
+
+    // 读位置跳到了写端正在写入的范围内时为负
+    if(avail <= 0)
+        return 0;
+    return (size_t)avail > rd->ring->size ? rd->ring->size : (size_t)avail;
+}
+
+/**
+ * @brief 读取数据，数据不足时只读取已有的部分
+ * @attention 每个读端只能由一个使用者调用，不同读端互不影响。
+ *            读取期间数据被写端覆盖时，读位置跳到仍完整的最早数据并返回0，
+ *            丢失字节数见bcast_reader_lost，由调用者决定是否重新读取。
+ *            不在内部重试或等待写端，可在抢占了写端的中断中调用
+ *
+ * @param rd: 读端
+ * @param buf: 读取缓冲区
+ * @param len: 读取长度
+ * @return size_t 实际读取的长度，0表示没有数据或发生了覆盖
+ */
+size_t bcast_reader_read(bcast_reader_t *rd, uint8_t *buf, size_t len)
+{
+    bcast_ring_t *br = rd->ring;
+    uint32_t pos, idx, oldest;
+    int32_t avail;
+    size_t n, sequential_bytes;
+
+    pos = rd->pos;
+    avail = (int32_t)(rb_load_acquire(br->tail) - pos);
+    if(avail <= 0)
+        return 0;
+    n = (size_t)avail;
+    if(n <= br->size)
+    {
+        if(n > len)
+            n = len;
+        idx = pos & br->mask;
+        sequential_bytes = br->size - idx;
+        if(sequential_bytes >= n)
+        {
+            memcpy(buf, br->buf + idx, n);
+        }
+        else
+        {
+            memcpy(buf, br->buf + idx, sequential_bytes);
+            memcpy(buf + sequential_bytes, br->buf, n - sequential_bytes);
+        }
+        // 拷贝完成后确认这段数据没有被写端改写
+        bcast_fence_acquire();
+        if(rb_load_relaxed(br->claim) - pos <= br->size)
+        {
+            rd->pos = pos + (uint32_t)n;
+            return n;
+        }
+    }
+    // 被覆盖，跳到仍完整的最早数据，写端可能仍在写入，可读数据在其发布tail后出现
+    oldest = rb_load_acquire(br->claim) - (uint32_t)br->size;
+    if((int32_t)(oldest - pos) > 0)
+    {
+        rd->lost += oldest - pos;
+        rd->pos = oldest;
+    }
+    return 0;
+}
+
+/**
+ * @brief 查询并清零读端的丢失字节数
+ *
+ * @param rd: 读端
+ * @return uint32_t 上次查询以来被覆盖而丢失的字节数
+ */
+uint32_t bcast_reader_lost(bcast_reader_t *rd)
+{
+    uint32_t lost = rd->lost;
+
+    rd->lost = 0;
+    return lost;
+}
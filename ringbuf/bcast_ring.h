@@ -0,0 +1,40 @@
+#ifndef __BCAST_RING_H__
+#define __BCAST_RING_H__
+
+#include "ringbuf.h"
+
+/*
+ * 单写端多读端的广播环形缓冲区：写端只写一次，每个读端有自己的读位置，
+ * 同一份数据可以被Ymodem、命令行、日志等多个使用者各自读取。
+ * 写端从不等待读端，读端跟不上时被覆盖的数据计入该读端的丢失字节数，
+ * 读位置跳到仍有效的最早数据，不影响其他读端。
+ * 读端不会等待写端：bcast_reader_read发现数据在读取期间被覆盖时跳过被覆盖的部分并返回0，
+ * 此时bcast_reader_lost不为0，调用者可立即再次读取；
+ * 写端被打断在写入中途时可读数据暂时为0，等写端完成后再读取
+ */
+struct bcast_ring_s
+{
+    uint8_t *buf;
+    RINGBUF_ATOMIC(uint32_t) tail;  // 写计数，自由递增，已写完可读的位置
+    RINGBUF_ATOMIC(uint32_t) claim; // 写端正在写入的结束位置，读端据此判断读取期间数据是否被覆盖
+    size_t size;                    // 缓冲区长度，2的幂
+    uint32_t mask;                  // size - 1
+};
+typedef struct bcast_ring_s bcast_ring_t;
+
+struct bcast_reader_s
+{
+    bcast_ring_t *ring;
+    uint32_t pos;                   // 读计数，只由本读端修改
+    uint32_t lost;                  // 被覆盖而丢失的字节数
+};
+typedef struct bcast_reader_s bcast_reader_t;
+
+uint8_t bcast_ring_init(bcast_ring_t *br, void *buf, size_t size);
+void bcast_ring_write(bcast_ring_t *br, const uint8_t *data, size_t len);
+void bcast_reader_attach(bcast_ring_t *br, bcast_reader_t *rd);
+size_t bcast_reader_available(const bcast_reader_t *rd);
+size_t bcast_reader_read(bcast_reader_t *rd, uint8_t *buf, size_t len);
+uint32_t bcast_reader_lost(bcast_reader_t *rd);
+
+#endif /* __BCAST_RING_H__ */
@@ -25,6 +25,20 @@ volatile uint8_t rx_len = 0;
 volatile uint8_t recv_end_flag = 0;
 uint8_t rx_buffer[100] = {0};
 ringbuf_t *terb = NULL;
+#if UART1_RX_MODE == UART1_RX_RING
+static uint32_t uart1_rx_overrun = 0; // 读取不及时被DMA覆盖的次数
+#elif UART1_RX_MODE == UART1_RX_FRAME
+static uint8_t uart1_rx_frame[UART1_RX_FRAME_NUM][UART1_RX_FRAME_SIZE];
+static volatile uint16_t uart1_rx_frame_len[UART1_RX_FRAME_NUM];
+static volatile uint32_t uart1_rx_frame_wr = 0;  // 已接收完的帧数，DMA正在写第wr % NUM个缓冲区
+static volatile uint32_t uart1_rx_frame_rd = 0;  // 已释放的帧数，只由读端修改
+static volatile uint8_t uart1_rx_frame_armed = 0;    // DMA是否在接收
+static volatile uint8_t uart1_rx_frame_claimed = 0;  // 帧是否由uart1_rx_frame_get的使用者处理，否则拷贝到terb
+static uint32_t uart1_rx_frame_stall = 0;        // 缓冲区全部等待处理、接收暂停的次数
+#endif
+static ringbuf_t *uart1_txrb = NULL;         // 发送队列，DMA直接从其存储区发送
+static volatile uint16_t uart1_tx_busy = 0;  // 正在DMA发送的长度，0表示空闲
+static uint32_t uart1_tx_drop = 0;           // 队列已满或发送失败被丢弃的字节数
 /* USER CODE END 0 */
 
 UART_HandleTypeDef huart1;
@@ -56,8 +70,31 @@ void MX_USART1_UART_Init(void)
         Error_Handler();
     }
     /* USER CODE BEGIN USART1_Init 2 */
+    uart1_txrb = ringbuf_new(UART1_TX_RING_SIZE);
+    if (uart1_txrb == NULL)
+    {
+        Error_Handler();
+    }
     __HAL_UART_ENABLE_IT(&huart1, UART_IT_IDLE);
+#if UART1_RX_MODE == UART1_RX_RING
+    // 接收DMA改为循环模式，目标为terb的存储区，DMA不再停止
+    hdma_usart1_rx.Init.Mode = DMA_CIRCULAR;
+    if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
+    {
+        Error_Handler();
+    }
+    terb = ringbuf_new(UART1_RX_RING_SIZE);
+    if (terb == NULL)
+    {
+        Error_Handler();
+    }
+    HAL_UART_Receive_DMA(&huart1, terb->buf, terb->size);
+#elif UART1_RX_MODE == UART1_RX_FRAME
+    uart1_rx_frame_armed = 1;
+    HAL_UART_Receive_DMA(&huart1, uart1_rx_frame[0], UART1_RX_FRAME_SIZE);
+#else
     HAL_UART_Receive_DMA(&huart1, rx_buffer, BUFFER_SIZE);
+#endif
     /* USER CODE END USART1_Init 2 */
 }
 
@@ -161,41 +198,425 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef *uartHandle)
 }
 
 /* USER CODE BEGIN 1 */
-void DMA_UART_Send(uint8_t *buf, uint8_t len)
+/**
+ * @brief 发送队列空闲时，用DMA发送队列中的第一段连续数据
+ * @attention 调用时需关中断，由入队、发送完成和出错中断调用；
+ *            HAL返回忙或出错时没有发送完成中断来重试，丢弃队列中的数据并计入uart1_tx_drop，
+ *            否则数据会一直留在队列中，之后入队的数据也发不出去
+ */
+static void uart1_tx_start(void)
 {
-    if (HAL_UART_Transmit_DMA(&huart1, buf, len) != HAL_OK)
+    ringbuf_span_t span1, span2;
+
+    if (uart1_tx_busy || ringbuf_peek(uart1_txrb, &span1, &span2) == 0)
     {
-        Error_Handler();
+        return;
+    }
+    // 回绕的第二段在本段发送完成后再发送
+    if (HAL_UART_Transmit_DMA(&huart1, span1.ptr, (uint16_t)span1.len) == HAL_OK)
+    {
+        uart1_tx_busy = (uint16_t)span1.len;
+    }
+    else
+    {
+        ringbuf_consume(uart1_txrb, span1.len + span2.len);
+        uart1_tx_drop += span1.len + span2.len;
+    }
+}
+
+/**
+ * @brief 数据放入发送队列后立即返回，不等待发送完成
+ * @attention 可在主循环和中断中调用，队列空间不足时只放入能放下的部分
+ *
+ * @param buf: 数据，返回后即可复用
+ * @param len: 数据长度
+ * @return size_t 实际放入队列的长度
+ */
+size_t uart1_write(const uint8_t *buf, size_t len)
+{
+    ringbuf_span_t span1, span2;
+    uint32_t primask;
+    size_t n;
+
+    if (uart1_txrb == NULL)
+    {
+        return 0;
+    }
+    // 多个调用者共用一个写端，入队期间关中断
+    primask = __get_PRIMASK();
+    __disable_irq();
+    n = ringbuf_write_reserve(uart1_txrb, len, &span1, &span2);
+    memcpy(span1.ptr, buf, span1.len);
+    memcpy(span2.ptr, buf + span1.len, span2.len);
+    ringbuf_write_commit(uart1_txrb, n);
+    uart1_tx_drop += len - n;
+    uart1_tx_start();
+    __set_PRIMASK(primask);
+    return n;
+}
+
+/**
+ * @brief 查询发送队列已满或发送失败被丢弃的字节数
+ *
+ * @return uint32_t 丢弃的字节数
+ */
+uint32_t uart1_tx_drop_count(void)
+{
+    return uart1_tx_drop;
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    uint32_t primask;
+
+    if (huart->Instance == USART1)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        // 释放发送完的一段，接着发送下一段
+        ringbuf_consume(uart1_txrb, uart1_tx_busy);
+        uart1_tx_busy = 0;
+        uart1_tx_start();
+        __set_PRIMASK(primask);
+    }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    uint32_t primask;
+
+    // 发送DMA出错时HAL结束发送并回到READY，不会再有发送完成中断
+    if (huart->Instance == USART1 && uart1_tx_busy && huart->gState == HAL_UART_STATE_READY)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        // 出错的一段可能已发出一部分，丢弃而不重发
+        ringbuf_consume(uart1_txrb, uart1_tx_busy);
+        uart1_tx_drop += uart1_tx_busy;
+        uart1_tx_busy = 0;
+        uart1_tx_start();
+        __set_PRIMASK(primask);
     }
 }
-unsigned char uart_tx_buf[128];
+
+void DMA_UART_Send(uint8_t *buf, uint16_t len)
+{
+    uart1_write(buf, len);
+}
+
 void uart1_printf(const char *format, ...)
 {
-    uint16_t len;
+    char line[UART1_TX_LINE_SIZE];
+    int len;
     va_list args;
     va_start(args, format);
-    len = vsnprintf((char *)uart_tx_buf, sizeof(uart_tx_buf) + 1, (char *)format, args);
+    len = vsnprintf(line, sizeof(line), format, args);
     va_end(args);
-    HAL_UART_Transmit_DMA(&huart1, uart_tx_buf, len);
+    if (len <= 0)
+    {
+        return;
+    }
+    // 超长时vsnprintf返回完整长度，只发送截断后的部分
+    if (len >= (int)sizeof(line))
+    {
+        len = sizeof(line) - 1;
+    }
+    uart1_write((const uint8_t *)line, (size_t)len);
+}
+
+/**
+ * @brief 在buf上启动一次DMA接收
+ * @attention UART1_RX_RING/UART1_RX_FRAME模式下接收DMA一直在运行，返回HAL_BUSY
+ *
+ * @return HAL_StatusTypeDef HAL_OK:启动成功
+ */
+HAL_StatusTypeDef DMA_UART_Receive(uint8_t *buf, uint8_t len)
+{
+    return HAL_UART_Receive_DMA(&huart1, buf, len);
+}
+
+#if UART1_RX_MODE == UART1_RX_RING
+/**
+ * @brief 根据DMA剩余计数(NDTR)推进terb的写位置
+ * @attention 在串口空闲中断、DMA半满和全满中断中调用，
+ *            三者可能互相抢占，计算和提交期间关中断
+ */
+static void uart1_rx_ring_update(void)
+{
+    uint32_t primask, dma_pos, tail_pos, count, bytes_free;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    // DMA下一个要写的位置，NDTR == size时为0
+    dma_pos = (terb->size - huart1.hdmarx->Instance->NDTR) & terb->mask;
+    tail_pos = (uint32_t)((const uint8_t *)ringbuf_tail(terb) - terb->buf);
+    count = (dma_pos - tail_pos) & terb->mask;
+    if (count)
+    {
+        bytes_free = ringbuf_bytes_free(terb);
+        if (count > bytes_free)
+        {
+            // 读取不及时，未读的数据已被覆盖，只提交剩余空间保证已用长度不超过size
+            uart1_rx_overrun++;
+            count = bytes_free;
+        }
+        ringbuf_write_commit(terb, count);
+    }
+    __set_PRIMASK(primask);
 }
 
-void DMA_UART_Receive(uint8_t *buf, uint8_t len)
+/**
+ * @brief 丢弃已收到的全部数据，包括DMA已写入、尚未提交到terb的部分
+ * @attention 只能由读端调用
+ */
+void uart1_rx_flush(void)
 {
-    HAL_UART_Receive_DMA(&huart1, buf, len);
+    uart1_rx_ring_update();
+    ringbuf_consume(terb, ringbuf_bytes_used(terb));
+}
+
+/**
+ * @brief 查询循环接收的溢出次数
+ *
+ * @return uint32_t 溢出次数
+ */
+uint32_t uart1_rx_overrun_count(void)
+{
+    return uart1_rx_overrun;
+}
+
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1)
+    {
+        uart1_rx_ring_update();
+    }
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1)
+    {
+        uart1_rx_ring_update();
+    }
 }
 
 void user_uart1IT_ReceiveCallback(void)
 {
     if (__HAL_UART_GET_FLAG(&huart1, UART_FLAG_IDLE) != RESET)
     {
-		__HAL_UART_CLEAR_IDLEFLAG(&huart1);
-		HAL_UART_DMAStop(&huart1);
-        rx_len = 100 - huart1.hdmarx->Instance->NDTR;
-        ringbuf_write(terb, rx_buffer, rx_len);
-        // recv_end_flag = 1;
-		HAL_UART_Receive_DMA(&huart1, rx_buffer, BUFFER_SIZE);
+        __HAL_UART_CLEAR_IDLEFLAG(&huart1);
+        uart1_rx_ring_update();
+    }
+}
+#elif UART1_RX_MODE == UART1_RX_FRAME
+/**
+ * @brief 有空闲缓冲区时在第wr % NUM个缓冲区上启动DMA，否则暂停接收
+ * @attention 调用时需关中断
+ */
+static void uart1_rx_frame_arm(void)
+{
+    uint32_t wr = uart1_rx_frame_wr;
+
+    if (wr - uart1_rx_frame_rd < UART1_RX_FRAME_NUM)
+    {
+        uart1_rx_frame_armed = 1;
+        HAL_UART_Receive_DMA(&huart1, uart1_rx_frame[wr % UART1_RX_FRAME_NUM], UART1_RX_FRAME_SIZE);
+    }
+    else
+    {
+        // 所有缓冲区都在等待处理，由uart1_rx_frame_release重新启动
+        uart1_rx_frame_armed = 0;
+        uart1_rx_frame_stall++;
+    }
+}
+
+/**
+ * @brief 一帧接收结束(总线空闲或缓冲区满)，交出当前缓冲区并在下一个缓冲区上重新启动DMA
+ * @attention 只停止接收DMA，不影响正在进行的发送；
+ *            帧未被占用时拷贝到terb，缓冲区直接复用；
+ *            在串口空闲中断和DMA全满中断中调用，期间关中断
+ */
+static void uart1_rx_frame_end(void)
+{
+    uint32_t primask, wr;
+    uint16_t len;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (uart1_rx_frame_armed)
+    {
+        HAL_UART_AbortReceive(&huart1);
+        len = UART1_RX_FRAME_SIZE - huart1.hdmarx->Instance->NDTR;
+        if (len && !uart1_rx_frame_claimed)
+        {
+            ringbuf_write(terb, uart1_rx_frame[uart1_rx_frame_wr % UART1_RX_FRAME_NUM], len);
+        }
+        else if (len)
+        {
+            // 先写长度再发布帧
+            wr = uart1_rx_frame_wr;
+            uart1_rx_frame_len[wr % UART1_RX_FRAME_NUM] = len;
+            uart1_rx_frame_wr = wr + 1;
+        }
+        uart1_rx_frame_arm();
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 占用或交还按帧接收，丢弃尚未处理的帧和正在接收的半帧
+ * @attention 占用期间收到的帧由uart1_rx_frame_get取出，不再拷贝到terb；
+ *            占用前收到的数据(如启动传输的命令)不会被当作第一帧
+ *
+ * @param claim: 1:占用 0:交还，之后收到的帧拷贝到terb
+ */
+void uart1_rx_frame_claim(uint8_t claim)
+{
+    uart1_rx_frame_claimed = claim;
+    uart1_rx_flush();
+}
+
+/**
+ * @brief 丢弃已收到的全部数据：待处理的帧、正在接收的半帧和terb中未读的数据
+ * @attention 只能由读端调用
+ */
+void uart1_rx_flush(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (uart1_rx_frame_armed)
+    {
+        HAL_UART_AbortReceive(&huart1);
+    }
+    uart1_rx_frame_rd = uart1_rx_frame_wr;
+    uart1_rx_frame_arm();
+    __set_PRIMASK(primask);
+    if (terb != NULL)
+    {
+        ringbuf_consume(terb, ringbuf_bytes_used(terb));
+    }
+}
+
+/**
+ * @brief 取出最早接收完的一帧，处理完后调用uart1_rx_frame_release释放
+ * @attention 只能由一个读端调用，释放前重复调用返回同一帧
+ *
+ * @param len: 返回帧长度
+ * @return uint8_t* 帧数据，没有待处理的帧时返回NULL
+ */
+uint8_t *uart1_rx_frame_get(uint16_t *len)
+{
+    uint32_t rd = uart1_rx_frame_rd;
+
+    if (rd == uart1_rx_frame_wr)
+    {
+        return NULL;
+    }
+    *len = uart1_rx_frame_len[rd % UART1_RX_FRAME_NUM];
+    return uart1_rx_frame[rd % UART1_RX_FRAME_NUM];
+}
+
+/**
+ * @brief 释放uart1_rx_frame_get取出的帧，缓冲区交还给DMA使用
+ *
+ */
+void uart1_rx_frame_release(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (uart1_rx_frame_rd != uart1_rx_frame_wr)
+    {
+        uart1_rx_frame_rd++;
+        if (!uart1_rx_frame_armed)
+        {
+            uart1_rx_frame_arm();
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 查询缓冲区全部等待处理、接收暂停的次数，暂停期间收到的数据丢失
+ *
+ * @return uint32_t 暂停次数
+ */
+uint32_t uart1_rx_frame_stall_count(void)
+{
+    return uart1_rx_frame_stall;
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1)
+    {
+        uart1_rx_frame_end();
+    }
+}
+
+void user_uart1IT_ReceiveCallback(void)
+{
+    if (__HAL_UART_GET_FLAG(&huart1, UART_FLAG_IDLE) != RESET)
+    {
+        __HAL_UART_CLEAR_IDLEFLAG(&huart1);
+        uart1_rx_frame_end();
+    }
+}
+#else
+/**
+ * @brief 把rx_buffer中收到的数据拷贝到terb并重新启动DMA
+ * @attention 在串口空闲中断和DMA全满中断中调用，连续超过BUFFER_SIZE字节的数据(如Ymodem数据包)不会丢失
+ */
+static void uart1_rx_legacy_end(void)
+{
+    // 只停止接收，HAL_UART_DMAStop会同时停止发送队列的DMA
+    HAL_UART_AbortReceive(&huart1);
+    rx_len = BUFFER_SIZE - huart1.hdmarx->Instance->NDTR;
+    ringbuf_write(terb, rx_buffer, rx_len);
+    // recv_end_flag = 1;
+    HAL_UART_Receive_DMA(&huart1, rx_buffer, BUFFER_SIZE);
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1)
+    {
+        uart1_rx_legacy_end();
+    }
+}
+
+void user_uart1IT_ReceiveCallback(void)
+{
+    if (__HAL_UART_GET_FLAG(&huart1, UART_FLAG_IDLE) != RESET)
+    {
+        __HAL_UART_CLEAR_IDLEFLAG(&huart1);
+        uart1_rx_legacy_end();
+    }
+}
+
+/**
+ * @brief 丢弃已收到的全部数据，包括rx_buffer中尚未拷贝到terb的部分
+ * @attention 只能由读端调用
+ */
+void uart1_rx_flush(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    HAL_UART_AbortReceive(&huart1);
+    HAL_UART_Receive_DMA(&huart1, rx_buffer, BUFFER_SIZE);
+    __set_PRIMASK(primask);
+    if (terb != NULL)
+    {
+        ringbuf_consume(terb, ringbuf_bytes_used(terb));
     }
 }
+#endif
 /* USER CODE END 1 */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -30,6 +30,7 @@ extern "C" {
 /* USER CODE BEGIN Includes */
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "ringbuf.h"
 /* USER CODE END Includes */
 
@@ -37,6 +38,25 @@ extern UART_HandleTypeDef huart1;
 
 /* USER CODE BEGIN Private defines */
 #define BUFFER_SIZE  100
+
+/* 串口1接收方式 */
+#define UART1_RX_LEGACY     0   // 每次空闲中断停止DMA，把rx_buffer拷贝到terb后重新启动
+#define UART1_RX_RING       1   // DMA循环模式直接接收到terb的存储区，中断只推进写位置
+#define UART1_RX_FRAME      2   // 多缓冲区按帧接收，空闲中断交出一帧并立即在下一个缓冲区上重新启动DMA，
+                                // 帧由uart1_rx_frame_claim占用(如Ymodem传输期间)，未占用时拷贝到terb
+#ifndef UART1_RX_MODE
+#define UART1_RX_MODE       UART1_RX_LEGACY // Ymodem在各方式下均可使用，UART1_RX_FRAME下1K数据包不经过terb
+#endif
+#define UART1_RX_RING_SIZE  256 // 循环接收的ringbuf大小，2的幂，需大于两次读取之间最多收到的字节数
+#define UART1_RX_FRAME_NUM  2   // 帧缓冲区个数，至少2个，NUM帧都在等待处理时暂停接收
+#define UART1_RX_FRAME_SIZE 1029    // 帧缓冲区大小，Ymodem 1K数据包: 3字节包头 + 1024字节数据 + 2字节CRC
+#if UART1_RX_MODE == UART1_RX_FRAME && UART1_RX_FRAME_NUM < 2
+#error "UART1_RX_FRAME_NUM must be at least 2"
+#endif
+
+/* 串口1发送队列 */
+#define UART1_TX_RING_SIZE  512 // 发送队列大小，2的幂，写满时多出的数据被丢弃
+#define UART1_TX_LINE_SIZE  128 // uart1_printf单次格式化的最大长度(含结尾'\0')
 extern volatile uint8_t rx_len;
 extern volatile uint8_t recv_end_flag;
 extern uint8_t rx_buffer[100];
@@ -46,9 +66,20 @@ extern ringbuf_t *terb;
 void MX_USART1_UART_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-void DMA_UART_Send(uint8_t *buf, uint8_t len);
-void DMA_UART_Receive(uint8_t *buf, uint8_t len);
+void DMA_UART_Send(uint8_t *buf, uint16_t len);
+size_t uart1_write(const uint8_t *buf, size_t len);
+uint32_t uart1_tx_drop_count(void);
+HAL_StatusTypeDef DMA_UART_Receive(uint8_t *buf, uint8_t len);
 void user_uart1IT_ReceiveCallback(void);
+void uart1_rx_flush(void);
+#if UART1_RX_MODE == UART1_RX_RING
+uint32_t uart1_rx_overrun_count(void);
+#elif UART1_RX_MODE == UART1_RX_FRAME
+void uart1_rx_frame_claim(uint8_t claim);
+uint8_t *uart1_rx_frame_get(uint16_t *len);
+void uart1_rx_frame_release(void);
+uint32_t uart1_rx_frame_stall_count(void);
+#endif
 void uart1_printf(const char *format, ...);
 /* USER CODE END Prototypes */
 
@@ -0,0 +1,149 @@
+#include "msgring.h"
+#include <string.h>
+
+/*
+ * 每条记录为 [uint32_t 长度][数据][填充到MSGRING_ALIGN]，head/tail与ringbuf相同为自由递增计数。
+ * 写位置到缓冲区末尾放不下整条记录时，写入长度为MSGRING_PAD的填充头，
+ * 末尾剩余空间作废，记录从缓冲区开头存放；读端遇到填充头直接跳到开头
+ */
+#define MSGRING_HDR     sizeof(uint32_t)
+#define MSGRING_PAD     0xFFFFFFFFu
+
+#define msgring_round(len)  (((len) + MSGRING_HDR + MSGRING_ALIGN - 1) & ~(uint32_t)(MSGRING_ALIGN - 1))
+
+/**
+ * @brief 初始化msgring
+ *
+ * @param mr: msgring指针
+ * @param buf: 存储区，按MSGRING_ALIGN对齐
+ * @param size: 存储区长度，必须为2的幂且不小于2 * MSGRING_ALIGN
+ * @return uint8_t 1:成功 0:参数错误
+ */
+uint8_t msgring_init(msgring_t *mr, void *buf, size_t size)
+{
+    if(mr == NULL || buf == NULL || ((uintptr_t)buf & (MSGRING_ALIGN - 1)))
+        return 0;
+    if(size < 2 * MSGRING_ALIGN || (size & (size - 1)) || size > 0x80000000u)
+        return 0;
+    mr->buf = buf;
+    mr->size = size;
+    mr->mask = (uint32_t)(size - 1);
+    msgring_reset(mr);
+    return 1;
+}
+
+/**
+ * @brief 清空msgring
+ * @attention SPSC模式下只能在读写两端都停止时调用
+ *
+ * @param mr: msgring指针
+ */
+void msgring_reset(msgring_t *mr)
+{
+    rb_store_release(mr->head, 0);
+    rb_store_release(mr->tail, 0);
+}
+
+/**
+ * @brief 单条记录的最大长度
+ * @attention 取存储区的一半，保证msgring为空时无论写位置在哪，
+ *            加上末尾的填充也能放下最长的记录
+ *
+ * @param mr: msgring指针
+ * @return size_t 最大长度
+ */
+size_t msgring_max_len(const msgring_t *mr)
+{
+    return mr->size / 2 - MSGRING_HDR;
+}
+
+int msgring_is_empty(const msgring_t *mr)
+{
+    return rb_load_acquire(mr->head) == rb_load_acquire(mr->tail);
+}
+
+/**
+ * @brief 写入一条记录
+ * @attention SPSC模式下只能由一个写端调用(如串口中断)
+ *
+ * @param mr: msgring指针
+ * @param data: 记录数据
+ * @param len: 记录长度，不超过msgring_max_len
+ * @return uint8_t 1:写入成功 0:空间不足，不写入任何数据
+ */
+uint8_t msgring_push(msgring_t *mr, const void *data, size_t len)
+{
+    uint32_t head, tail, idx, need, pad;
+
+    if(len > msgring_max_len(mr))
+        return 0;
+
+    tail = rb_load_relaxed(mr->tail);
+    head = rb_load_acquire(mr->head);
+    need = msgring_round((uint32_t)len);
+    idx = tail & mr->mask;
+    // 末尾放不下时整段填充，对齐保证末尾至少能放下一个填充头
+    pad = (need > mr->size - idx) ? (uint32_t)(mr->size - idx) : 0;
+    if((tail - head) + pad + need > mr->size)
+        return 0;
+
+    if(pad)
+    {
+        *(uint32_t *)(mr->buf + idx) = MSGRING_PAD;
+        idx = 0;
+    }
+    *(uint32_t *)(mr->buf + idx) = (uint32_t)len;
+    memcpy(mr->buf + idx + MSGRING_HDR, data, len);
+    // 填充和记录一起发布
+    rb_store_release(mr->tail, tail + pad + need);
+    return 1;
+}
+
+/**
+ * @brief 查看最早的一条记录，不拷贝，处理完后用msgring_pop释放
+ * @attention SPSC模式下只能由读端调用，会跳过末尾的填充
+ *
+ * @param mr: msgring指针
+ * @param len: 返回记录长度
+ * @return void* 记录数据，连续且按MSGRING_ALIGN对齐，没有记录时返回NULL
+ */
+void * msgring_front(msgring_t *mr, size_t *len)
+{
+    uint32_t head, tail, idx, hdr;
+
+    head = rb_load_relaxed(mr->head);
+    tail = rb_load_acquire(mr->tail);
+    if(head == tail)
+        return NULL;
+
+    idx = head & mr->mask;
+    hdr = *(uint32_t *)(mr->buf + idx);
+    if(hdr == MSGRING_PAD)
+    {
+        // 写端先写填充再写记录后一起发布，跳过填充后一定还有记录
+        head += (uint32_t)(mr->size - idx);
+        rb_store_release(mr->head, head);
+        idx = 0;
+        hdr = *(uint32_t *)mr->buf;
+    }
+    *len = hdr;
+    return mr->buf + idx + MSGRING_HDR;
+}
+
+/**
+ * @brief 释放最早的一条记录，使写端可以复用空间
+ * @attention SPSC模式下只能由读端调用
+ *
+ * @param mr: msgring指针
+ * @return uint8_t 1:释放成功 0:msgring为空
+ */
+uint8_t msgring_pop(msgring_t *mr)
+{
+    size_t len;
+
+    if(msgring_front(mr, &len) == NULL)
+        return 0;
+    // msgring_front已跳过填充，head指向记录头
+    rb_store_release(mr->head, rb_load_relaxed(mr->head) + msgring_round((uint32_t)len));
+    return 1;
+}
@@ -0,0 +1,30 @@
+#ifndef __MSGRING_H__
+#define __MSGRING_H__
+
+#include "ringbuf.h"
+
+#define MSGRING_ALIGN   4   // 记录头和记录数据的对齐
+
+/*
+ * 按记录存储的环形缓冲区，每条记录带长度头，记录不会跨越缓冲区末尾，
+ * 放不下时在末尾填充，从缓冲区开头存放，读端总能拿到连续的整条记录
+ */
+struct msgring_s
+{
+    uint8_t *buf;
+    RINGBUF_ATOMIC(uint32_t) head;  // 读计数，自由递增，只由读端修改
+    RINGBUF_ATOMIC(uint32_t) tail;  // 写计数，自由递增，只由写端修改
+    size_t size;                    // 缓冲区长度，2的幂
+    uint32_t mask;                  // size - 1
+};
+typedef struct msgring_s msgring_t;
+
+uint8_t msgring_init(msgring_t *mr, void *buf, size_t size);
+void msgring_reset(msgring_t *mr);
+size_t msgring_max_len(const msgring_t *mr);
+int msgring_is_empty(const msgring_t *mr);
+uint8_t msgring_push(msgring_t *mr, const void *data, size_t len);
+void * msgring_front(msgring_t *mr, size_t *len);
+uint8_t msgring_pop(msgring_t *mr);
+
+#endif /* __MSGRING_H__ */
@@ -8,18 +8,34 @@ static size_t buff_sum = 0;
 static uint8_t rb_buff[RINGBUF_SIZE];
 #endif
 
+/*
+ * head/tail为自由递增的32位读/写计数，溢出后自然回绕，
+ * 缓冲区下标为计数 & (size - 1)，已用字节数恒为tail - head，可以写满全部size字节。
+ * SPSC模式下head只由读端(消费者)写，tail只由写端(生产者)写：
+ * 读取对方的计数用acquire，保证看到对方发布的数据；
+ * 更新自己的计数用release，保证数据先于计数可见(rb_load_acquire/rb_store_release)
+ */
+
+#ifdef RINGBUF_SPSC
+// C++代码看到的计数字段是普通uint32_t，两者布局必须相同
+typedef char ringbuf_atomic_layout_check[sizeof(RINGBUF_ATOMIC(uint32_t)) == sizeof(uint32_t)
+                                         && _Alignof(RINGBUF_ATOMIC(uint32_t)) == _Alignof(uint32_t) ? 1 : -1];
+#endif
+
 /**
  * @brief 创建一个新的ringbuf
  *
- * @param length: 缓冲区长度
+ * @param length: 缓冲区长度，必须为2的幂
  * @return ringbuf_t 创建的ringbuf指针
  */
 ringbuf_t * ringbuf_new(size_t length)
 {
+    if(length == 0 || (length & (length - 1)) || length > 0x80000000u)
+        return NULL;
     #ifdef DYNAMIC_MALLOC
     ringbuf_t *rb = MALLOC(sizeof(struct ringbuf_s));
     #else
-    if(head_sum > RINGBUF_HEAD)
+    if(head_sum >= RINGBUF_HEAD)
         return NULL;
     ringbuf_t *rb = rb_head + head_sum;
     head_sum++;
@@ -27,6 +43,7 @@ ringbuf_t * ringbuf_new(size_t length)
     if(rb)
     {
         rb->size = length;
+        rb->mask = (uint32_t)(length - 1);
         #ifdef DYNAMIC_MALLOC
         rb->buf = MALLOC(rb->size);
         #else
@@ -52,9 +69,16 @@ size_t ringbuf_buffer_size(const ringbuf_t *rb)
     return rb->size;
 }
 
+/**
+ * @brief 清空ringbuf
+ * @attention SPSC模式下只能在读写两端都停止时调用
+ *
+ * @param rb: ringbuf指针
+ */
 void ringbuf_reset(ringbuf_t *rb)
 {
-    rb->head = rb->tail = rb->buf;
+    rb_store_release(rb->head, 0);
+    rb_store_release(rb->tail, 0);
 }
 
 void ringbuf_free(ringbuf_t *rb)
@@ -67,111 +91,352 @@ void ringbuf_free(ringbuf_t *rb)
     #endif
 }
 
-static const uint8_t * ringbuf_end(const ringbuf_t *rb)
-{
-    return (rb->buf + (ringbuf_buffer_size(rb) - 1));
-}
-
 size_t ringbuf_bytes_free(const ringbuf_t *rb)
 {
-    if (rb->head > rb->tail)
-        return (rb->head - rb->tail);
-    else
-        return (ringbuf_buffer_size(rb) - (rb->tail - rb->head));
+    uint32_t head = rb_load_acquire(rb->head);
+    return rb->size - (rb_load_acquire(rb->tail) - head);
 }
 
 size_t ringbuf_bytes_used(const ringbuf_t *rb)
 {
-    return (ringbuf_buffer_size(rb) - ringbuf_bytes_free(rb));
+    uint32_t head = rb_load_acquire(rb->head);
+    return rb_load_acquire(rb->tail) - head;
 }
 
 int ringbuf_is_full(const ringbuf_t *rb)
 {
-    return ringbuf_bytes_free(rb) == 0;
+    return ringbuf_bytes_used(rb) == rb->size;
 }
 
 int ringbuf_is_empty(const ringbuf_t *rb)
 {
-    return (ringbuf_bytes_free(rb) == ringbuf_buffer_size(rb));
+    return rb_load_acquire(rb->head) == rb_load_acquire(rb->tail);
 }
 
 const void * ringbuf_tail(const ringbuf_t *rb)
 {
-    return rb->tail;
+    return rb->buf + (rb_load_acquire(rb->tail) & rb->mask);
 }
 
 const void * ringbuf_head(const ringbuf_t *rb)
 {
-    return rb->head;
+    return rb->buf + (rb_load_acquire(rb->head) & rb->mask);
 }
 
-uint8_t ringbuf_write(ringbuf_t *rb, const uint8_t *buf, size_t length)
+/**
+ * @brief 预留写入空间，不拷贝数据，调用者直接写入span(如DMA目标地址)后提交
+ * @attention SPSC模式下只能由写端调用
+ *
+ * @param rb: ringbuf指针
+ * @param length: 希望预留的长度
+ * @param span1: 第一段连续空间(从写位置到缓冲区末尾)
+ * @param span2: 回绕后的第二段连续空间，不需要回绕时长度为0
+ * @return size_t 实际预留的长度(span1.len + span2.len)，0表示ringbuf已满
+ */
+size_t ringbuf_write_reserve(ringbuf_t *rb, size_t length, ringbuf_span_t *span1, ringbuf_span_t *span2)
 {
     size_t bytes_free, sequential_bytes;
+    uint32_t tail, idx;
 
-    if(rb == NULL || ringbuf_is_full(rb))
-        return 0;
-
-    bytes_free = ringbuf_bytes_free(rb);
+    // tail只有本端写，relaxed即可；head由读端发布
+    tail = rb_load_relaxed(rb->tail);
+    bytes_free = rb->size - (tail - rb_load_acquire(rb->head));
     if(length > bytes_free)
         length = bytes_free;
 
-    if(rb->head > rb->tail)
+    idx = tail & rb->mask;
+    sequential_bytes = rb->size - idx;
+    span1->ptr = rb->buf + idx;
+    span2->ptr = rb->buf;
+    if(sequential_bytes >= length)
     {
-        memcpy(rb->tail, buf, length);
-        rb->tail += length;
+        span1->len = length;
+        span2->len = 0;
     }
     else
     {
-        sequential_bytes = ringbuf_end(rb) - rb->tail + 1;
-        if(sequential_bytes >= length)
-        {
-            memcpy(rb->tail, buf, length);
-            rb->tail += length;
-        }
-        else
-        {
-            memcpy(rb->tail, buf, sequential_bytes);
-            rb->tail = rb->buf;
-            memcpy(rb->tail, buf + sequential_bytes, length - sequential_bytes);
-            rb->tail += (length - sequential_bytes);
-        }
+        span1->len = sequential_bytes;
+        span2->len = length - sequential_bytes;
+    }
+    return length;
+}
+
+/**
+ * @brief 提交写入的数据，使读端可见
+ *
+ * @param rb: ringbuf指针
+ * @param length: 已写入的长度，不超过ringbuf_write_reserve的返回值
+ */
+void ringbuf_write_commit(ringbuf_t *rb, size_t length)
+{
+    // 数据写完后再发布tail
+    rb_store_release(rb->tail, rb_load_relaxed(rb->tail) + (uint32_t)length);
+}
+
+/**
+ * @brief 查看已有数据，不拷贝，调用者直接读取span后用ringbuf_consume释放
+ * @attention SPSC模式下只能由读端调用
+ *
+ * @param rb: ringbuf指针
+ * @param span1: 第一段连续数据(从读位置到缓冲区末尾)
+ * @param span2: 回绕后的第二段连续数据，不需要回绕时长度为0
+ * @return size_t 数据总长度(span1.len + span2.len)，0表示ringbuf为空
+ */
+size_t ringbuf_peek(const ringbuf_t *rb, ringbuf_span_t *span1, ringbuf_span_t *span2)
+{
+    size_t bytes_used, sequential_bytes;
+    uint32_t head, idx;
+
+    // head只有本端写，relaxed即可；tail由写端发布
+    head = rb_load_relaxed(rb->head);
+    bytes_used = rb_load_acquire(rb->tail) - head;
+
+    idx = head & rb->mask;
+    sequential_bytes = rb->size - idx;
+    span1->ptr = rb->buf + idx;
+    span2->ptr = rb->buf;
+    if(sequential_bytes >= bytes_used)
+    {
+        span1->len = bytes_used;
+        span2->len = 0;
+    }
+    else
+    {
+        span1->len = sequential_bytes;
+        span2->len = bytes_used - sequential_bytes;
     }
+    return bytes_used;
+}
+
+/**
+ * @brief 释放已读取的数据，使写端可以复用空间
+ *
+ * @param rb: ringbuf指针
+ * @param length: 释放的长度，不超过ringbuf_peek的返回值
+ */
+void ringbuf_consume(ringbuf_t *rb, size_t length)
+{
+    // 数据读完后再释放空间给写端
+    rb_store_release(rb->head, rb_load_relaxed(rb->head) + (uint32_t)length);
+}
+
+/**
+ * @brief 写入数据，空间不足时只写入能放下的部分
+ * @attention SPSC模式下只能由一个写端调用(如串口中断)
+ *
+ * @param rb: ringbuf指针
+ * @param buf: 数据
+ * @param length: 数据长度
+ * @return uint8_t 1:写入成功 0:ringbuf已满
+ */
+uint8_t ringbuf_write(ringbuf_t *rb, const uint8_t *buf, size_t length)
+{
+    ringbuf_span_t span1, span2;
+
+    if(rb == NULL)
+        return 0;
+
+    length = ringbuf_write_reserve(rb, length, &span1, &span2);
+    if(length == 0)
+        return 0;
+    memcpy(span1.ptr, buf, span1.len);
+    memcpy(span2.ptr, buf + span1.len, span2.len);
+    ringbuf_write_commit(rb, length);
     return 1;
 }
 
+/**
+ * @brief 读取数据，数据不足时只读取已有的部分
+ * @attention SPSC模式下只能由一个读端调用(如主循环)
+ *
+ * @param rb: ringbuf指针
+ * @param buf: 读取缓冲区
+ * @param length: 读取长度
+ * @return uint8_t 1:读取成功 0:ringbuf为空
+ */
 uint8_t ringbuf_read(ringbuf_t *rb, uint8_t *buf, size_t length)
 {
-    size_t bytes_used, sequential_bytes;
+    ringbuf_span_t span1, span2;
 
-    if(rb == NULL || ringbuf_is_empty(rb))
+    if(rb == NULL || ringbuf_peek(rb, &span1, &span2) == 0)
         return 0;
 
-    bytes_used = ringbuf_bytes_used(rb);
-    if(length > bytes_used)
-        length = bytes_used;
+    if(length <= span1.len)
+    {
+        memcpy(buf, span1.ptr, length);
+    }
+    else
+    {
+        if(length > span1.len + span2.len)
+            length = span1.len + span2.len;
+        memcpy(buf, span1.ptr, span1.len);
+        memcpy(buf + span1.len, span2.ptr, length - span1.len);
+    }
+    ringbuf_consume(rb, length);
+    return 1;
+}
+
+/**
+ * @brief 在连续内存中查找字节，对齐后每次比较一个32位字
+ * @attention newlib-nano等按字节实现的memchr在长数据上较慢
+ *
+ * @param p: 数据
+ * @param c: 要查找的字节
+ * @param n: 数据长度
+ * @return const uint8_t* 第一次出现的位置，未找到返回NULL
+ */
+static const uint8_t * rb_memchr(const uint8_t *p, uint8_t c, size_t n)
+{
+    uint32_t pattern, word;
 
-    if(rb->head >= rb->tail)
+    while(n && ((uintptr_t)p & (sizeof(uint32_t) - 1)))
     {
-        sequential_bytes = ringbuf_end(rb) - rb->head + 1;
-        if(sequential_bytes >= length)
-        {
-            memcpy(buf, rb->head, length);
-            rb->head += length;
-        }
-        else
+        if(*p == c)
+            return p;
+        p++;
+        n--;
+    }
+    pattern = c * 0x01010101u;
+    while(n >= sizeof(uint32_t))
+    {
+        // 与c相同的字节异或后为0，再检测字中是否有0字节
+        memcpy(&word, p, sizeof(word));
+        word ^= pattern;
+        if((word - 0x01010101u) & ~word & 0x80808080u)
+            break;
+        p += sizeof(uint32_t);
+        n -= sizeof(uint32_t);
+    }
+    while(n)
+    {
+        if(*p == c)
+            return p;
+        p++;
+        n--;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 从数据的第from个字节开始，依次在两段中查找
+ *
+ * @return size_t 相对读位置的偏移，未找到返回RINGBUF_NOT_FOUND
+ */
+static size_t rb_find_from(const ringbuf_span_t *span1, const ringbuf_span_t *span2, size_t from, uint8_t c)
+{
+    const uint8_t *p;
+
+    if(from < span1->len)
+    {
+        p = rb_memchr(span1->ptr + from, c, span1->len - from);
+        if(p)
+            return p - span1->ptr;
+        from = span1->len;
+    }
+    if(from < span1->len + span2->len)
+    {
+        p = rb_memchr(span2->ptr + (from - span1->len), c, span1->len + span2->len - from);
+        if(p)
+            return span1->len + (p - span2->ptr);
+    }
+    return RINGBUF_NOT_FOUND;
+}
+
+/**
+ * @brief 在已有数据中查找字节，不拷贝、不移动读位置
+ * @attention SPSC模式下只能由读端调用
+ *
+ * @param rb: ringbuf指针
+ * @param c: 要查找的字节
+ * @return size_t 相对读位置的偏移，未找到返回RINGBUF_NOT_FOUND
+ */
+size_t ringbuf_find(const ringbuf_t *rb, uint8_t c)
+{
+    ringbuf_span_t span1, span2;
+
+    ringbuf_peek(rb, &span1, &span2);
+    return rb_find_from(&span1, &span2, 0, c);
+}
+
+/**
+ * @brief 在已有数据中查找字节序列，可跨越缓冲区末尾，不拷贝、不移动读位置
+ * @attention SPSC模式下只能由读端调用
+ *
+ * @param rb: ringbuf指针
+ * @param pattern: 要查找的字节序列
+ * @param len: 序列长度
+ * @return size_t 序列起始相对读位置的偏移，未找到返回RINGBUF_NOT_FOUND
+ */
+size_t ringbuf_find_seq(const ringbuf_t *rb, const uint8_t *pattern, size_t len)
+{
+    ringbuf_span_t span1, span2;
+    size_t used, off, i, j;
+
+    if(len == 0)
+        return 0;
+    used = ringbuf_peek(rb, &span1, &span2);
+    if(len > used)
+        return RINGBUF_NOT_FOUND;
+
+    for(off = 0; ; off++)
+    {
+        // 先找首字节，再逐字节比较其余部分
+        off = rb_find_from(&span1, &span2, off, pattern[0]);
+        if(off == RINGBUF_NOT_FOUND || off > used - len)
+            return RINGBUF_NOT_FOUND;
+        for(i = 1; i < len; i++)
         {
-            memcpy(buf, rb->head, sequential_bytes);
-            rb->head = rb->buf;
-            memcpy(buf + sequential_bytes, rb->head, length - sequential_bytes);
-            rb->head += (length - sequential_bytes);
+            j = off + i;
+            if((j < span1.len ? span1.ptr[j] : span2.ptr[j - span1.len]) != pattern[i])
+                break;
         }
+        if(i == len)
+            return off;
     }
+}
+
+/**
+ * @brief 读取一行，与fgets相同保留结尾的'\n'并以'\0'结束
+ * @attention SPSC模式下只能由读端调用。没有完整的一行时不读取，
+ *            除非一行超过size - 1字节或ringbuf已满，此时读取最多size - 1字节的部分行
+ *
+ * @param rb: ringbuf指针
+ * @param buf: 读取缓冲区
+ * @param size: 缓冲区长度，含结尾的'\0'
+ * @return size_t 读取的字节数(不含'\0')，0表示还没有完整的一行，此时buf为空字符串
+ */
+size_t ringbuf_readline(ringbuf_t *rb, char *buf, size_t size)
+{
+    ringbuf_span_t span1, span2;
+    size_t used, len;
+
+    if(size == 0)
+        return 0;
+    buf[0] = '\0';
+    if(rb == NULL || size < 2)
+        return 0;
+
+    used = ringbuf_peek(rb, &span1, &span2);
+    len = rb_find_from(&span1, &span2, 0, '\n');
+    if(len != RINGBUF_NOT_FOUND)
+        len++;
+    else if(used >= size - 1 || used == rb->size)
+        len = used;
     else
+        return 0;
+    if(len > size - 1)
+        len = size - 1;
+
+    if(len <= span1.len)
     {
-        memcpy(buf, rb->head, length);
-        rb->head += length;
+        memcpy(buf, span1.ptr, len);
     }
-    return 1;
+    else
+    {
+        memcpy(buf, span1.ptr, span1.len);
+        memcpy(buf + span1.len, span2.ptr, len - span1.len);
+    }
+    buf[len] = '\0';
+    ringbuf_consume(rb, len);
+    return len;
 }
-
@@ -5,6 +5,23 @@
 #include <stdlib.h>
 
 // #define DYNAMIC_MALLOC
+#define RINGBUF_SPSC    // 单生产者单消费者无锁模式(如中断写、主循环读)，需要C11 <stdatomic.h>
+
+#if defined(RINGBUF_SPSC) && defined(__cplusplus)
+// C++只使用结构体声明，原子访问都在.c中完成，字段用布局相同的普通类型，见ringbuf.c中的检查
+#define RINGBUF_ATOMIC(type)    type
+#elif defined(RINGBUF_SPSC)
+#include <stdatomic.h>
+#define RINGBUF_ATOMIC(type)    _Atomic(type)
+#define rb_load_acquire(p)      atomic_load_explicit(&(p), memory_order_acquire)
+#define rb_load_relaxed(p)      atomic_load_explicit(&(p), memory_order_relaxed)
+#define rb_store_release(p, v)  atomic_store_explicit(&(p), (v), memory_order_release)
+#else
+#define RINGBUF_ATOMIC(type)    type
+#define rb_load_acquire(p)      (p)
+#define rb_load_relaxed(p)      (p)
+#define rb_store_release(p, v)  ((p) = (v))
+#endif
 
 #ifdef DYNAMIC_MALLOC
 #define MALLOC  malloc
@@ -17,11 +34,22 @@
 struct ringbuf_s
 {
     uint8_t *buf;
-    uint8_t *head, *tail;
-    size_t size;
+    RINGBUF_ATOMIC(uint32_t) head;  // 读计数，自由递增，只由读端修改
+    RINGBUF_ATOMIC(uint32_t) tail;  // 写计数，自由递增，只由写端修改
+    size_t size;                    // 缓冲区长度，2的幂
+    uint32_t mask;                  // size - 1
 };
 typedef struct ringbuf_s ringbuf_t;
 
+#define RINGBUF_NOT_FOUND   ((size_t)-1)    // ringbuf_find/ringbuf_find_seq未找到
+
+// ringbuf中的一段连续内存
+typedef struct ringbuf_span
+{
+    uint8_t *ptr;
+    size_t len;
+} ringbuf_span_t;
+
 ringbuf_t * ringbuf_new(size_t length);
 size_t ringbuf_buffer_size(const ringbuf_t *rb);
 void ringbuf_reset(ringbuf_t *rb);
@@ -33,5 +61,12 @@ const void * ringbuf_tail(const ringbuf_t *rb);
 const void * ringbuf_head(const ringbuf_t *rb);
 uint8_t ringbuf_write(ringbuf_t *rb, const uint8_t *buf, size_t length);
 uint8_t ringbuf_read(ringbuf_t *rb, uint8_t *buf, size_t length);
+size_t ringbuf_write_reserve(ringbuf_t *rb, size_t length, ringbuf_span_t *span1, ringbuf_span_t *span2);
+void ringbuf_write_commit(ringbuf_t *rb, size_t length);
+size_t ringbuf_peek(const ringbuf_t *rb, ringbuf_span_t *span1, ringbuf_span_t *span2);
+void ringbuf_consume(ringbuf_t *rb, size_t length);
+size_t ringbuf_find(const ringbuf_t *rb, uint8_t c);
+size_t ringbuf_find_seq(const ringbuf_t *rb, const uint8_t *pattern, size_t len);
+size_t ringbuf_readline(ringbuf_t *rb, char *buf, size_t size);
 
 #endif /* __RINGBUF_H__ */
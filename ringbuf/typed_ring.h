@@ -0,0 +1,89 @@
+#ifndef __TYPED_RING_H__
+#define __TYPED_RING_H__
+
+#include "ringbuf.h"
+
+/*
+ * 按元素类型和编译期容量生成的定长环形队列，用于传感器采样、LED命令等小结构体。
+ * 入队/出队为一次结构体赋值，下标为自由递增计数 & (capacity - 1)，不调用memcpy。
+ * 与ringbuf相同，RINGBUF_SPSC模式下为单生产者单消费者无锁队列。
+ *
+ * 用法:
+ *   TYPED_RING_DECLARE(sample_ring, sample_t, 16)
+ *   static sample_ring_t samples;            // 全局/静态变量初始即为空，否则先调用sample_ring_reset
+ *   sample_ring_push(&samples, &s);          // 中断中
+ *   while(sample_ring_pop(&samples, &s))     // 主循环中
+ */
+
+/**
+ * @brief 生成队列类型name##_t和操作函数name##_push/pop/front/count/is_empty/is_full/reset
+ *
+ * @param name: 队列名
+ * @param type: 元素类型
+ * @param capacity: 容量，必须为2的幂
+ */
+#define TYPED_RING_DECLARE(name, type, capacity)                                    \
+typedef char name##_capacity_must_be_power_of_two                                   \
+    [((capacity) > 0 && ((capacity) & ((capacity) - 1)) == 0) ? 1 : -1];            \
+                                                                                    \
+typedef struct name##_s                                                             \
+{                                                                                   \
+    RINGBUF_ATOMIC(uint32_t) head;  /* 读计数，只由读端修改 */                       \
+    RINGBUF_ATOMIC(uint32_t) tail;  /* 写计数，只由写端修改 */                       \
+    type buf[capacity];                                                             \
+} name##_t;                                                                         \
+                                                                                    \
+static inline void name##_reset(name##_t *q)                                        \
+{                                                                                   \
+    rb_store_release(q->head, 0);                                                   \
+    rb_store_release(q->tail, 0);                                                   \
+}                                                                                   \
+                                                                                    \
+static inline uint32_t name##_count(const name##_t *q)                              \
+{                                                                                   \
+    uint32_t head = rb_load_acquire(q->head);                                       \
+    return rb_load_acquire(q->tail) - head;                                         \
+}                                                                                   \
+                                                                                    \
+static inline int name##_is_empty(const name##_t *q)                                \
+{                                                                                   \
+    return name##_count(q) == 0;                                                    \
+}                                                                                   \
+                                                                                    \
+static inline int name##_is_full(const name##_t *q)                                 \
+{                                                                                   \
+    return name##_count(q) == (capacity);                                           \
+}                                                                                   \
+                                                                                    \
+/* 写入一个元素，队列已满返回0 */                                                    \
+static inline uint8_t name##_push(name##_t *q, const type *v)                       \
+{                                                                                   \
+    uint32_t tail = rb_load_relaxed(q->tail);                                       \
+    if(tail - rb_load_acquire(q->head) == (capacity))                               \
+        return 0;                                                                   \
+    q->buf[tail & ((capacity) - 1)] = *v;                                           \
+    rb_store_release(q->tail, tail + 1);                                            \
+    return 1;                                                                       \
+}                                                                                   \
+                                                                                    \
+/* 读取并移除最早的元素，队列为空返回0 */                                            \
+static inline uint8_t name##_pop(name##_t *q, type *v)                              \
+{                                                                                   \
+    uint32_t head = rb_load_relaxed(q->head);                                       \
+    if(rb_load_acquire(q->tail) == head)                                            \
+        return 0;                                                                   \
+    *v = q->buf[head & ((capacity) - 1)];                                           \
+    rb_store_release(q->head, head + 1);                                            \
+    return 1;                                                                       \
+}                                                                                   \
+                                                                                    \
+/* 查看最早的元素，不移除，队列为空返回NULL */                                       \
+static inline type * name##_front(name##_t *q)                                      \
+{                                                                                   \
+    uint32_t head = rb_load_relaxed(q->head);                                       \
+    if(rb_load_acquire(q->tail) == head)                                            \
+        return NULL;                                                                \
+    return &q->buf[head & ((capacity) - 1)];                                        \
+}
+
+#endif /* __TYPED_RING_H__ */
@@ -0,0 +1,107 @@
+#ifndef __TYPED_RING_HPP__
+#define __TYPED_RING_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * typed_ring.h的C++版本，按元素类型和编译期容量特化的单生产者单消费者无锁队列。
+ * 入队/出队为一次赋值，下标为自由递增计数 & (N - 1)。
+ *
+ * 用法:
+ *   static rb::typed_ring<sample_t, 16> samples;
+ *   samples.push(s);                // 中断中
+ *   while (samples.pop(s)) { ... }  // 主循环中
+ */
+
+namespace rb {
+
+template <typename T, std::size_t N>
+class typed_ring {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "typed_ring capacity must be a power of two");
+    static_assert(N <= 0x80000000u, "typed_ring capacity too large");
+
+public:
+    typed_ring() = default;
+    typed_ring(const typed_ring &) = delete;
+    typed_ring &operator=(const typed_ring &) = delete;
+
+    static constexpr std::size_t capacity() { return N; }
+
+    /**
+     * @brief 写入一个元素，只能由写端调用
+     *
+     * @return bool false:队列已满
+     */
+    bool push(const T &v)
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        buf_[tail & mask] = v;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 读取并移除最早的元素，只能由读端调用
+     *
+     * @return bool false:队列为空
+     */
+    bool pop(T &v)
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) == head) {
+            return false;
+        }
+        v = buf_[head & mask];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 查看最早的元素，不移除，只能由读端调用
+     *
+     * @return T* 队列为空时返回nullptr
+     */
+    T *front()
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) == head) {
+            return nullptr;
+        }
+        return &buf_[head & mask];
+    }
+
+    std::size_t size() const
+    {
+        uint32_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() == N; }
+
+    /**
+     * @brief 清空队列，只能在读写两端都停止时调用
+     *
+     */
+    void reset()
+    {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_release);
+    }
+
+private:
+    static constexpr uint32_t mask = static_cast<uint32_t>(N - 1);
+
+    std::atomic<uint32_t> head_{0};     // 读计数，只由读端修改
+    std::atomic<uint32_t> tail_{0};     // 写计数，只由写端修改
+    T buf_[N];
+};
+
+} // namespace rb
+
+#endif /* __TYPED_RING_HPP__ */
@@ -44,6 +44,28 @@ _strSpiFlash SpiFlashPraList[]=
 
 LIST_HEAD(DevSpiFlashRoot);
 
+#ifdef SPI_USE_MEM_POOL
+/* 节点内存池 */
+MEM_POOL_STORAGE(DevSpiFlashNodeStorage, sizeof(DevSpiFlashNode), DEV_SPI_FLASH_NODE_NUM);
+static mem_pool_t *DevSpiFlashNodePool = NULL;
+#endif
+
+/**
+ * @brief 申请一个spi flash节点空间
+ *
+ * @return DevSpiFlashNode* 节点指针，NULL表示申请失败
+ */
+static DevSpiFlashNode *dev_spiflash_node_alloc(void)
+{
+#ifdef SPI_USE_MEM_POOL
+    if(DevSpiFlashNodePool == NULL)
+        DevSpiFlashNodePool = mem_pool_create(sizeof(DevSpiFlashNode), DEV_SPI_FLASH_NODE_NUM, DevSpiFlashNodeStorage);
+    return (DevSpiFlashNode *)mem_pool_get(DevSpiFlashNodePool);
+#else
+    return (DevSpiFlashNode *)MALLOC(sizeof(DevSpiFlashNode));
+#endif
+}
+
 /**
  * @brief FLASH写使能
  *
@@ -446,7 +468,9 @@ bool dev_spiflash_register(const DevSpiFlash *dev)
 		申请一个节点空间
 
 	*/
-	node = (DevSpiFlashNode *)MALLOC(sizeof(DevSpiFlashNode));
+	node = dev_spiflash_node_alloc();
+	if(node == NULL)
+		return false;
 	list_add(&(node->list), &DevSpiFlashRoot);
 	memcpy((uint8_t *)&node->dev, (uint8_t *)dev, sizeof(DevSpiFlash));
 	node->gd = -1;
@@ -5,6 +5,12 @@
 #include "linux_list.h"
 #include <stdbool.h>
 
+#ifdef SPI_USE_MEM_POOL
+#ifndef DEV_SPI_FLASH_NODE_NUM
+#define DEV_SPI_FLASH_NODE_NUM 2 // spi flash设备节点最大数量
+#endif
+#endif
+
 /*SPI FLASH 信息*/
 typedef struct
 {
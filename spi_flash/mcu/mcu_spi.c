@@ -36,6 +36,46 @@ LIST_HEAD(DevSpiRoot);
 /* 定义spi通道链表头 */
 LIST_HEAD(DevSpiChRoot);
 
+#ifdef SPI_USE_MEM_POOL
+/* 节点内存池 */
+MEM_POOL_STORAGE(DevSpiNodeStorage, sizeof(DevSpiNode), DEV_SPI_NODE_NUM);
+MEM_POOL_STORAGE(DevSpiChNodeStorage, sizeof(DevSpiChNode), DEV_SPI_CH_NODE_NUM);
+static mem_pool_t *DevSpiNodePool = NULL;
+static mem_pool_t *DevSpiChNodePool = NULL;
+#endif
+
+/**
+ * @brief 申请一个spi控制器节点空间
+ *
+ * @return DevSpiNode* 节点指针，NULL表示申请失败
+ */
+static DevSpiNode *mcu_spi_node_alloc(void)
+{
+#ifdef SPI_USE_MEM_POOL
+    if(DevSpiNodePool == NULL)
+        DevSpiNodePool = mem_pool_create(sizeof(DevSpiNode), DEV_SPI_NODE_NUM, DevSpiNodeStorage);
+    return (DevSpiNode *)mem_pool_get(DevSpiNodePool);
+#else
+    return (DevSpiNode *)MALLOC(sizeof(DevSpiNode));
+#endif
+}
+
+/**
+ * @brief 申请一个spi通道节点空间
+ *
+ * @return DevSpiChNode* 节点指针，NULL表示申请失败
+ */
+static DevSpiChNode *mcu_spich_node_alloc(void)
+{
+#ifdef SPI_USE_MEM_POOL
+    if(DevSpiChNodePool == NULL)
+        DevSpiChNodePool = mem_pool_create(sizeof(DevSpiChNode), DEV_SPI_CH_NODE_NUM, DevSpiChNodeStorage);
+    return (DevSpiChNode *)mem_pool_get(DevSpiChNodePool);
+#else
+    return (DevSpiChNode *)MALLOC(sizeof(DevSpiChNode));
+#endif
+}
+
 /**
  * @brief 硬件spi初始化
  *
@@ -418,7 +458,9 @@ bool mcu_spi_register(const DevSpi *dev)
     /*
         申请一个节点空间
 	*/
-	p = (DevSpiNode *)MALLOC(sizeof(DevSpiNode));
+	p = mcu_spi_node_alloc();
+	if(p == NULL)
+		return false;
 	list_add(&(p->list), &DevSpiRoot);
 
 	memcpy((uint8_t *)&p->dev, (uint8_t *)dev, sizeof(DevSpi));
@@ -491,7 +533,9 @@ bool mcu_spich_register(const DevSpiCh *dev)
 	/*
 		申请一个节点空间
 	*/
-	p = (DevSpiChNode *)MALLOC(sizeof(DevSpiChNode));
+	p = mcu_spich_node_alloc();
+	if(p == NULL)
+		return false;
 	list_add(&(p->list), &DevSpiChRoot);
 	memcpy((uint8_t *)&p->dev, (uint8_t *)dev, sizeof(DevSpiCh));
 	p->gd = -1;
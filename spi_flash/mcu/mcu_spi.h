@@ -11,6 +11,18 @@
 #define MALLOC malloc
 #define FREE   free
 
+#define SPI_USE_MEM_POOL // 设备节点从固定大小内存池分配，注释掉则使用MALLOC
+
+#ifdef SPI_USE_MEM_POOL
+#include "mem_pool.h"
+#ifndef DEV_SPI_NODE_NUM
+#define DEV_SPI_NODE_NUM    4 // spi控制器节点最大数量
+#endif
+#ifndef DEV_SPI_CH_NODE_NUM
+#define DEV_SPI_CH_NODE_NUM 4 // spi通道节点最大数量
+#endif
+#endif
+
 #define mcu_io_setbit(mcu_port, mcu_pin) \
         mcu_port->BSRR = mcu_pin;
 